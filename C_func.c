@@ -5,7 +5,7 @@
 
 // Functions used to manipulate C_fun
 
-typedef void (*cfunc)(forth_state_t*);
+static sef_int_t opcode_of_cfunc(cfunc func);
 
 void sef_exec_cfunc(forth_state_t* fs, void* parameters) {
     cfunc* func_field = parameters;
@@ -19,6 +19,7 @@ void sef_register_cfunc(forth_state_t* fs, const char* name, cfunc func, bool is
     sef_allot_cell(fs);
     sef_int_t* parameters = sef_get_entry_parameter(fs->last_dictionary_entry);
     *parameters = (sef_int_t) func;
+    *sef_get_entry_code_field(fs->last_dictionary_entry) = opcode_of_cfunc(func);
     if (is_immediate) {
         sef_int_t* word_tag_field = sef_get_word_tag_field(fs->last_dictionary_entry);
         *word_tag_field |= WTM_IMMEDIATE;
@@ -48,7 +49,7 @@ static void rot(forth_state_t* fs) {
 }
 
 // dup
-static void DUP(forth_state_t* fs) {
+static void dup_word(forth_state_t* fs) {
     sef_int_t w1 = sef_pop_data(fs);
     sef_push_data(fs, w1);
     sef_push_data(fs, w1);
@@ -244,45 +245,303 @@ static void two_slash(forth_state_t* fs) {
     sef_push_data(fs, w2 >> w1);
 }
 
-// Flow control
+#if SEF_NATIVE_CORE_WORDS
+// Native core words
+// When SEF_NATIVE_CORE_WORDS is not set, they are defined in Forth in
+// tiny_core_forth_words.frt instead.
 
-// if
-static void if_runtine(forth_state_t* fs) {
-    sef_int_t destination_address = sef_pop_data(fs);
-    sef_int_t flag = sef_pop_data(fs);
-    if (!flag) {
-        fs->code_pointer = (sef_int_t*) destination_address;
+// 2dup
+static void two_dup(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+}
+
+// 2drop
+static void two_drop(forth_state_t* fs) {
+    sef_pop_data(fs);
+    sef_pop_data(fs);
+}
+
+// nip
+static void nip(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_pop_data(fs);
+    sef_push_data(fs, w1);
+}
+
+// over
+static void over(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w2);
+}
+
+// tuck
+static void tuck(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+}
+
+// 2over
+static void two_over(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_int_t w3 = sef_pop_data(fs);
+    sef_int_t w4 = sef_pop_data(fs);
+    sef_push_data(fs, w4);
+    sef_push_data(fs, w3);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w4);
+    sef_push_data(fs, w3);
+}
+
+// 2swap
+static void two_swap(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_int_t w3 = sef_pop_data(fs);
+    sef_int_t w4 = sef_pop_data(fs);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w4);
+    sef_push_data(fs, w3);
+}
+
+// ?dup
+static void question_dup(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_push_data(fs, w1);
+    if (w1) {
+        sef_push_data(fs, w1);
     }
 }
 
-// else
-static void else_runtime(forth_state_t* fs) {
-    sef_int_t destination_address = sef_pop_data(fs);
-    fs->code_pointer = (sef_int_t*) destination_address;
+// s>d
+static void s_to_d(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w1 < 0 ? -1 : 0);
+}
+
+// 1+
+static void one_plus(forth_state_t* fs) {
+    sef_push_data(fs, sef_pop_data(fs) + 1);
+}
+
+// 1-
+static void one_minus(forth_state_t* fs) {
+    sef_push_data(fs, sef_pop_data(fs) - 1);
+}
+
+// <>
+static void not_eq(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, FORTH_BOOL(w1 != w2));
+}
+
+// 0<>
+static void not_eq0(forth_state_t* fs) {
+    sef_push_data(fs, FORTH_BOOL(sef_pop_data(fs) != 0));
+}
+
+// >
+static void greater_than(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, FORTH_BOOL(w2 > w1));
+}
+
+// 0>
+static void greater0(forth_state_t* fs) {
+    sef_push_data(fs, FORTH_BOOL(sef_pop_data(fs) > 0));
+}
+
+// u>
+static void u_greater_than(forth_state_t* fs) {
+    sef_unsigned_t w1 = (sef_unsigned_t) sef_pop_data(fs);
+    sef_unsigned_t w2 = (sef_unsigned_t) sef_pop_data(fs);
+    sef_push_data(fs, FORTH_BOOL(w2 > w1));
 }
 
-// while
-static void while_runtime(forth_state_t* fs) {
-    dictionary_entry_t repeat_address = (dictionary_entry_t) sef_pop_data(fs);
+// >=
+static void greater_or_eq(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, FORTH_BOOL(w2 >= w1));
+}
+
+// <=
+static void less_or_eq(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, FORTH_BOOL(w2 <= w1));
+}
+
+// max
+static void max(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2 < w1 ? w1 : w2);
+}
+
+// min
+static void min(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2 < w1 ? w2 : w1);
+}
+
+// /mod
+static void slash_mod(forth_state_t* fs) {
+    // Symmetric division, as SM/REM
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2 % w1);
+    sef_push_data(fs, w2 / w1);
+}
+
+// mod
+static void mod(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2 % w1);
+}
+
+// /
+static void slash(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2 / w1);
+}
+
+// negate
+static void negate(forth_state_t* fs) {
+    sef_push_data(fs, -sef_pop_data(fs));
+}
+
+// invert
+static void invert(forth_state_t* fs) {
+    sef_push_data(fs, ~sef_pop_data(fs));
+}
+
+// 2*
+static void two_star(forth_state_t* fs) {
+    sef_push_data(fs, sef_pop_data(fs) << 1);
+}
+
+// +!
+static void plus_store(forth_state_t* fs) {
+    sef_int_t* addr = (sef_int_t*) sef_pop_data(fs);
+    sef_int_t data = sef_pop_data(fs);
+    *addr += data;
+}
+
+// cell
+static void cell(forth_state_t* fs) {
+    sef_push_data(fs, sizeof(sef_int_t));
+}
+
+// cell+
+static void cell_plus(forth_state_t* fs) {
+    sef_push_data(fs, sef_pop_data(fs) + sizeof(sef_int_t));
+}
+
+// char+
+static void char_plus(forth_state_t* fs) {
+    sef_push_data(fs, sef_pop_data(fs) + 1);
+}
+
+// ,
+static void comma(forth_state_t* fs) {
+    *fs->here.cell = sef_pop_data(fs);
+    sef_allot_cell(fs);
+}
+
+// c,
+static void c_comma(forth_state_t* fs) {
+    *fs->here.byte = (uint8_t) sef_pop_data(fs);
+    sef_allot(fs, 1);
+}
+
+// 2!
+static void two_store(forth_state_t* fs) {
+    sef_int_t* addr = (sef_int_t*) sef_pop_data(fs);
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    addr[0] = w1;
+    addr[1] = w2;
+}
+
+// 2@
+static void two_fetch(forth_state_t* fs) {
+    sef_int_t* addr = (sef_int_t*) sef_pop_data(fs);
+    sef_push_data(fs, addr[1]);
+    sef_push_data(fs, addr[0]);
+}
+
+static sef_unsigned_t align_address(sef_unsigned_t addr) {
+    return (addr + sizeof(sef_int_t) - 1) / sizeof(sef_int_t) * sizeof(sef_int_t);
+}
+
+// aligned
+static void aligned(forth_state_t* fs) {
+    sef_push_data(fs, (sef_int_t) align_address((sef_unsigned_t) sef_pop_data(fs)));
+}
+
+// align
+static void align(forth_state_t* fs) {
+    sef_unsigned_t here = (sef_unsigned_t) fs->here.byte;
+    sef_allot(fs, align_address(here) - here);
+}
+#endif
+
+// Flow control
+
+static void skip_cells(forth_state_t* fs, sef_int_t cells) {
+    if (fs->code_pointer != NULL) {
+        fs->code_pointer += cells;
+    }
+}
+
+// (0branch)
+static void zero_branch(forth_state_t* fs) {
+    dictionary_entry_t destination_address = (dictionary_entry_t) fs->code_pointer[1];
     sef_int_t flag = sef_pop_data(fs);
-    if (!flag) {
-        fs->code_pointer = repeat_address;
+    if (!flag && fs->code_pointer != NULL) {
+        fs->code_pointer = destination_address;
+    } else {
+        skip_cells(fs, 1);
     }
 }
 
-// repeat
-static void repeat_runtime(forth_state_t* fs) {
-    dictionary_entry_t begin_address = (dictionary_entry_t) sef_pop_data(fs);
-    fs->code_pointer = begin_address;
+// (branch)
+static void branch(forth_state_t* fs) {
+    fs->code_pointer = (dictionary_entry_t) fs->code_pointer[1];
 }
 
+// The loop-sys is a frame of three cells on the return stack: the address to
+// leave the loop to, the end value, and the loop counter on top. (do) and
+// (?do) read the address to leave the loop to from the cell after them,
+// (loop) and (+loop) read the address of the start of the loop the same way.
+
+// (?do)
 static void question_do_run_time(forth_state_t* fs) {
-    // It might be easier to that from Forth...
-    sef_int_t end_of_loop_pointer = sef_pop_data(fs);
+    sef_int_t end_of_loop_pointer = fs->code_pointer[1];
     sef_int_t loop_counter = sef_pop_data(fs);
     sef_int_t end_value = sef_pop_data(fs);
     // ?do can jump to the end
-    if (end_value == loop_counter) {
+    if (end_value == loop_counter && fs->code_pointer != NULL) {
         fs->code_pointer = (dictionary_entry_t) end_of_loop_pointer;
         return;
     }
@@ -290,20 +549,23 @@ static void question_do_run_time(forth_state_t* fs) {
     sef_push_return(fs, end_of_loop_pointer);
     sef_push_return(fs, end_value);
     sef_push_return(fs, loop_counter);
+    skip_cells(fs, 1);
 }
 
+// (do)
 static void do_run_time(forth_state_t* fs) {
-    sef_int_t end_of_loop_pointer = sef_pop_data(fs);
+    sef_int_t end_of_loop_pointer = fs->code_pointer[1];
     sef_int_t loop_counter = sef_pop_data(fs);
     sef_int_t end_value = sef_pop_data(fs);
     sef_push_return(fs, end_of_loop_pointer);
     sef_push_return(fs, end_value);
     sef_push_return(fs, loop_counter);
+    skip_cells(fs, 1);
 }
 
-// (+loop) takes as argument ( increment-value begining-of-the-loop-pointer )
+// (+loop)
 static void plus_loop_run_time(forth_state_t* fs) {
-    sef_int_t question_do_address = sef_pop_data(fs);
+    sef_int_t question_do_address = fs->code_pointer[1];
     sef_int_t increment = sef_pop_data(fs);
     sef_int_t old_loop_counter = sef_pop_return(fs);
     sef_int_t end_value = sef_pop_return(fs);
@@ -314,8 +576,9 @@ static void plus_loop_run_time(forth_state_t* fs) {
     sef_int_t check_sign_after = check_sign_before + increment;
     bool overflowed = increment > 0 && check_sign_after < check_sign_before;
     bool underflowed = increment < 0 && check_sign_after > check_sign_before;
-    if (overflowed || underflowed) {
+    if (overflowed || underflowed || fs->code_pointer == NULL) {
         sef_pop_return(fs); // End of loop address
+        skip_cells(fs, 1);
     } else {
         sef_push_return(fs, end_value);
         sef_push_return(fs, updated_loop_counter);
@@ -323,14 +586,15 @@ static void plus_loop_run_time(forth_state_t* fs) {
     }
 }
 
-// (loop) takes as argument ( begining-of-the-loop-pointer )
+// (loop)
 static void loop_run_time(forth_state_t* fs) {
-    sef_int_t question_do_address = sef_pop_data(fs);
+    sef_int_t question_do_address = fs->code_pointer[1];
     sef_int_t loop_counter = sef_pop_return(fs);
     sef_int_t end_value = sef_pop_return(fs);
     loop_counter++;
-    if (loop_counter == end_value) {
+    if (loop_counter == end_value || fs->code_pointer == NULL) {
         sef_pop_return(fs); // End of loop address
+        skip_cells(fs, 1);
     } else {
         sef_push_return(fs, end_value);
         sef_push_return(fs, loop_counter);
@@ -338,21 +602,56 @@ static void loop_run_time(forth_state_t* fs) {
     }
 }
 
+// i
+static void i_word(forth_state_t* fs) {
+    sef_int_t loop_counter = sef_pop_return(fs);
+    sef_push_return(fs, loop_counter);
+    sef_push_data(fs, loop_counter);
+}
+
+// j
+static void j_word(forth_state_t* fs) {
+    sef_int_t loop_counter = sef_pop_return(fs);
+    sef_int_t end_value = sef_pop_return(fs);
+    sef_int_t end_of_loop_pointer = sef_pop_return(fs);
+    sef_int_t outer_loop_counter = sef_pop_return(fs);
+    sef_push_return(fs, outer_loop_counter);
+    sef_push_return(fs, end_of_loop_pointer);
+    sef_push_return(fs, end_value);
+    sef_push_return(fs, loop_counter);
+    sef_push_data(fs, outer_loop_counter);
+}
+
+// unloop
+static void unloop(forth_state_t* fs) {
+    sef_pop_return(fs);
+    sef_pop_return(fs);
+    sef_pop_return(fs);
+}
+
+// leave
+static void leave(forth_state_t* fs) {
+    sef_pop_return(fs);
+    sef_pop_return(fs);
+    dictionary_entry_t end_off_loop = (dictionary_entry_t) sef_pop_return(fs);
+    if (fs->code_pointer != NULL) {
+        fs->code_pointer = end_off_loop;
+    }
+}
+
+// (of)
 static void of_run_time(forth_state_t* fs) {
-    dictionary_entry_t endof_pointer = (dictionary_entry_t) sef_pop_data(fs);
+    dictionary_entry_t endof_pointer = (dictionary_entry_t) fs->code_pointer[1];
     sef_int_t reference = sef_pop_data(fs);
     sef_int_t element = sef_pop_data(fs);
-    if (reference != element) {
+    if (reference != element && fs->code_pointer != NULL) {
         sef_push_data(fs, element);
         fs->code_pointer = endof_pointer;
+    } else {
+        skip_cells(fs, 1);
     }
 }
 
-static void endof_run_time(forth_state_t* fs) {
-    dictionary_entry_t endcase_pointer = (dictionary_entry_t) sef_pop_data(fs);
-    fs->code_pointer = endcase_pointer;
-}
-
 // Compilation helpers
 
 // (literal)
@@ -375,10 +674,70 @@ static void postpone_run_time(forth_state_t* fs) {
             fs->compiling = old_state;
         }
     } else {
-        *fs->here.cell++ = (sef_int_t) entry;
+        sef_compile_entry(fs, entry);
+    }
+}
+
+// Superinstructions
+// Each of them does the work of the sequence of words it is named after. Only
+// the first cell of the sequence is replaced by the superinstruction, which
+// then skips the other cells.
+
+// (literal-+)
+static void literal_add(forth_state_t* fs) {
+    sef_int_t number = fs->code_pointer[1];
+    sef_push_data(fs, sef_pop_data(fs) + number);
+    skip_cells(fs, 2);
+}
+
+// (dup-0branch)
+static void dup_zero_branch(forth_state_t* fs) {
+    dictionary_entry_t destination_address = (dictionary_entry_t) fs->code_pointer[2];
+    sef_int_t flag = sef_pop_data(fs);
+    sef_push_data(fs, flag);
+    if (!flag && fs->code_pointer != NULL) {
+        fs->code_pointer = destination_address;
+    } else {
+        skip_cells(fs, 2);
     }
 }
 
+// (0=-0branch)
+static void eq0_zero_branch(forth_state_t* fs) {
+    dictionary_entry_t destination_address = (dictionary_entry_t) fs->code_pointer[2];
+    sef_int_t flag = sef_pop_data(fs);
+    if (flag && fs->code_pointer != NULL) {
+        fs->code_pointer = destination_address;
+    } else {
+        skip_cells(fs, 2);
+    }
+}
+
+// (over-over)
+static void over_over(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_int_t w2 = sef_pop_data(fs);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+    sef_push_data(fs, w2);
+    sef_push_data(fs, w1);
+    skip_cells(fs, 1);
+}
+
+// (r>-drop)
+static void r_from_drop(forth_state_t* fs) {
+    sef_pop_return(fs);
+    skip_cells(fs, 1);
+}
+
+// (swap-drop)
+static void swap_drop(forth_state_t* fs) {
+    sef_int_t w1 = sef_pop_data(fs);
+    sef_pop_data(fs);
+    sef_push_data(fs, w1);
+    skip_cells(fs, 1);
+}
+
 // Memory management
 
 // cells
@@ -450,7 +809,7 @@ static void cstore(forth_state_t* fs) {
 
 // unused
 static void unused(forth_state_t* fs) {
-    sef_push_data(fs, SEF_FORTH_MEMORY_SIZE - (fs->here.byte - fs->forth_memory));
+    sef_push_data(fs, fs->forth_memory_size - (fs->here.byte - fs->forth_memory));
 }
 
 // C strings
@@ -623,6 +982,80 @@ static void words(forth_state_t* fs) {
     sef_display_dictionary(fs);
 }
 
+#if SEF_SEARCH_ORDER
+// Search order
+
+// forth-wordlist
+static void forth_wordlist(forth_state_t* fs) {
+    sef_push_data(fs, FORTH_WORDLIST);
+}
+
+// wordlist
+// Word lists need no memory of their own, they are only numbers stored in the
+// entries.
+static void wordlist(forth_state_t* fs) {
+    sef_push_data(fs, ++fs->wordlist_count);
+}
+
+// get-current
+static void get_current(forth_state_t* fs) {
+    sef_push_data(fs, fs->current_wordlist);
+}
+
+// set-current
+static void set_current(forth_state_t* fs) {
+    fs->current_wordlist = sef_pop_data(fs);
+}
+
+// get-order
+static void get_order(forth_state_t* fs) {
+    for (sef_int_t i=fs->search_order_size-1; i>=0; i--) {
+        sef_push_data(fs, fs->search_order[i]);
+    }
+    sef_push_data(fs, fs->search_order_size);
+}
+
+// set-order
+// -1 sets the minimum search order, which only has the Forth word list.
+static void set_order(forth_state_t* fs) {
+    sef_int_t size = sef_pop_data(fs);
+    if (size == -1) {
+        fs->search_order[0] = FORTH_WORDLIST;
+        fs->search_order_size = 1;
+        return;
+    }
+    if (size < 0 || size > SEARCH_ORDER_MAX) {
+        SEF_ERROR_OUT(fs, "Search order can't hold %li word lists.\n", (long) size);
+        return;
+    }
+    for (sef_int_t i=0; i<size; i++) {
+        fs->search_order[i] = sef_pop_data(fs);
+    }
+    fs->search_order_size = size;
+}
+
+// definitions
+static void definitions(forth_state_t* fs) {
+    if (fs->search_order_size > 0) {
+        fs->current_wordlist = fs->search_order[0];
+    }
+}
+
+// search-wordlist
+static void search_wordlist(forth_state_t* fs) {
+    sef_int_t wordlist = sef_pop_data(fs);
+    size_t name_size = (size_t) sef_pop_data(fs);
+    const char* name = (const char*) sef_pop_data(fs);
+    dictionary_entry_t entry = sef_search_wordlist(fs, name, name_size, wordlist);
+    if (entry == NULL) {
+        sef_push_data(fs, 0);
+    } else {
+        sef_push_data(fs, (sef_int_t) entry);
+        sef_push_data(fs, *sef_get_word_tag_field(entry) & WTM_IMMEDIATE ? 1 : -1);
+    }
+}
+#endif
+
 // Misc
 
 // emit
@@ -668,7 +1101,7 @@ static void pad(forth_state_t* fs) {
 // Given a string, return true if i's a valid query for environment?
 // Also put in the return pointer the constants to put on the stack.
 // ret[0] is the first element to put on the stack.
-static bool environment_reply(const char* query, size_t size, sef_int_t ret[static 2], size_t* number_of_returned_values) {
+static bool environment_reply(forth_state_t* fs, const char* query, size_t size, sef_int_t ret[static 2], size_t* number_of_returned_values) {
     *number_of_returned_values = 1;
     if (!strncmp(query, "/COUNTED-STRING", size)) {
         *ret = 0xFF;
@@ -695,9 +1128,13 @@ static bool environment_reply(const char* query, size_t size, sef_int_t ret[stat
         ret[1] = 0;
         *number_of_returned_values = 2;
     } else if (!strncmp(query, "RETURN-STACK-CELLS", size)) {
-        *ret = SEF_RETURN_STACK_SIZE;
+        *ret = fs->return_stack_size;
     } else if (!strncmp(query, "STACK-CELLS", size)) {
-        *ret = SEF_DATA_STACK_SIZE;
+        *ret = fs->data_stack_size;
+#if SEF_SEARCH_ORDER
+    } else if (!strncmp(query, "WORDLISTS", size)) {
+        *ret = SEARCH_ORDER_MAX;
+#endif
     } else {
         *number_of_returned_values = 0;
         return false;
@@ -711,7 +1148,7 @@ static void environment_query(forth_state_t* fs) {
     const char* str = (const char*) sef_pop_data(fs);
     sef_int_t ret[2];
     size_t number_of_returned_values = 0;
-    bool query_ret = environment_reply(str, size, ret, &number_of_returned_values);
+    bool query_ret = environment_reply(fs, str, size, ret, &number_of_returned_values);
     for (size_t i=0; i<number_of_returned_values; i++) {
         sef_push_data(fs, ret[i]);
     }
@@ -742,8 +1179,7 @@ static void find(forth_state_t* fs) {
 // Pop an XT and push a pointer to its parameters
 static void body(forth_state_t* fs) {
     dictionary_entry_t xt = (dictionary_entry_t) sef_pop_data(fs);
-    void* parameters = sef_get_entry_parameter(xt);
-    sef_push_data(fs, (sef_int_t) parameters);
+    sef_push_data(fs, (sef_int_t) sef_get_entry_body(fs, xt));
 }
 
 static void state(forth_state_t* fs) {
@@ -795,7 +1231,7 @@ struct c_func_s all_default_c_func[] = {
     // Stack manipulation
     {"swap", swap},
     {"rot", rot},
-    {"dup", DUP},
+    {"dup", dup_word},
     {"drop", drop},
     {">r", to_r},
     {"r>", r_from},
@@ -822,20 +1258,67 @@ struct c_func_s all_default_c_func[] = {
     {"lshift", lshift},
     {"rshift", rshift},
     {"2/", two_slash},
+#if SEF_NATIVE_CORE_WORDS
+    // Native core words
+    {"2dup", two_dup},
+    {"2drop", two_drop},
+    {"nip", nip},
+    {"over", over},
+    {"tuck", tuck},
+    {"2over", two_over},
+    {"2swap", two_swap},
+    {"?dup", question_dup},
+    {"s>d", s_to_d},
+    {"1+", one_plus},
+    {"1-", one_minus},
+    {"<>", not_eq},
+    {"0<>", not_eq0},
+    {">", greater_than},
+    {"0>", greater0},
+    {"u>", u_greater_than},
+    {">=", greater_or_eq},
+    {"<=", less_or_eq},
+    {"max", max},
+    {"min", min},
+    {"/mod", slash_mod},
+    {"mod", mod},
+    {"/", slash},
+    {"negate", negate},
+    {"invert", invert},
+    {"2*", two_star},
+    {"+!", plus_store},
+    {"cell", cell},
+    {"cell+", cell_plus},
+    {"char+", char_plus},
+    {",", comma},
+    {"c,", c_comma},
+    {"2!", two_store},
+    {"2@", two_fetch},
+    {"aligned", aligned},
+    {"align", align},
+#endif
     // Flow control
-    {"if", if_runtine},
-    {"else", else_runtime},
-    {"while", while_runtime},
-    {"repeat", repeat_runtime},
-    {"do", do_run_time},
-    {"?do", question_do_run_time},
-    {"+loop", plus_loop_run_time},
-    {"loop", loop_run_time},
-    {"of", of_run_time},
-    {"endof", endof_run_time},
+    {"(0branch)", zero_branch},
+    {"(branch)", branch},
+    {"(do)", do_run_time},
+    {"(?do)", question_do_run_time},
+    {"(+loop)", plus_loop_run_time},
+    {"(loop)", loop_run_time},
+    {"i", i_word},
+    {"j", j_word},
+    {"unloop", unloop},
+    {"leave", leave},
+    {"(of)", of_run_time},
     // Compilation helpers
     {"(literal)", literal},
     {"postpone", postpone_run_time},
+    // Superinstructions
+    {"(literal-+)", literal_add},
+    {"(dup-0branch)", dup_zero_branch},
+    {"(0=-0branch)", eq0_zero_branch},
+    {"(over-over)", over_over},
+    {"(r>-drop)", r_from_drop},
+    {"(swap-drop)", swap_drop},
     // Memory management
     {"allot", allot},
     {"cells", cells},
@@ -870,6 +1353,31 @@ struct c_func_s all_default_c_func[] = {
 #endif
     // Programming tools
     {"words", words},
+#if SEF_SEARCH_ORDER
+    // Search order
+    {"forth-wordlist", forth_wordlist},
+    {"wordlist", wordlist},
+    {"get-current", get_current},
+    {"set-current", set_current},
+    {"get-order", get_order},
+    {"set-order", set_order},
+    {"definitions", definitions},
+    {"search-wordlist", search_wordlist},
+#endif
+#if SEF_PROFILE_PAIRS
+    {".pairs", sef_print_pairs},
+#endif
+#if SEF_PROFILE
+    {"profile-start", sef_start_profiling},
+    {"profile-stop", sef_stop_profiling},
+    {"profile-report", sef_print_profile},
+#endif
+#if SEF_OPTIMIZER
+    {"optimized-cells", sef_optimized_cells},
+#endif
+#if SEF_IMAGE
+    {"save-image", sef_save_image_word},
+#endif
     // Misc
     {"emit", emit},
     {"key", key},
@@ -903,3 +1411,968 @@ void sef_register_default_cfunc(forth_state_t* fs) {
     }
 }
 
+const char* sef_default_cfunc_at(size_t index, cfunc* func) {
+    if (index >= sizeof(all_default_c_func) / sizeof(struct c_func_s)) {
+        return NULL;
+    }
+    *func = all_default_c_func[index].func;
+    return all_default_c_func[index].name;
+}
+
+
+/* ---------------------------- Threaded engine ----------------------------- */
+
+struct c_func_opcode_s {
+    cfunc func;
+    enum sef_opcode opcode;
+};
+
+// C functions with a dedicated implementation in the threaded engine
+static const struct c_func_opcode_s c_func_opcodes[] = {
+    {swap, OP_SWAP},
+    {rot, OP_ROT},
+    {dup_word, OP_DUP},
+    {drop, OP_DROP},
+    {to_r, OP_TO_R},
+    {r_from, OP_R_FROM},
+    {add, OP_ADD},
+    {sub, OP_SUB},
+    {mult, OP_MULT},
+    {less_than, OP_LESS_THAN},
+    {u_less_than, OP_U_LESS_THAN},
+    {less0, OP_LESS0},
+    {eq0, OP_EQ0},
+    {eq, OP_EQ},
+    {and, OP_AND},
+    {or, OP_OR},
+    {xor, OP_XOR},
+    {lshift, OP_LSHIFT},
+    {rshift, OP_RSHIFT},
+    {two_slash, OP_TWO_SLASH},
+    {zero_branch, OP_ZERO_BRANCH},
+    {branch, OP_BRANCH},
+    {question_do_run_time, OP_QUESTION_DO},
+    {do_run_time, OP_DO},
+    {plus_loop_run_time, OP_PLUS_LOOP},
+    {loop_run_time, OP_LOOP},
+    {i_word, OP_I},
+    {j_word, OP_J},
+    {unloop, OP_UNLOOP},
+    {leave, OP_LEAVE},
+    {of_run_time, OP_OF},
+    {literal, OP_LITERAL},
+    {cells, OP_CELLS},
+    {fetch, OP_FETCH},
+    {store, OP_STORE},
+    {cfetch, OP_CFETCH},
+    {cstore, OP_CSTORE},
+    {exit_word, OP_EXIT},
+    {execute, OP_EXECUTE},
+    {literal_add, OP_LITERAL_ADD},
+    {dup_zero_branch, OP_DUP_ZERO_BRANCH},
+    {eq0_zero_branch, OP_EQ0_ZERO_BRANCH},
+    {over_over, OP_OVER_OVER},
+    {r_from_drop, OP_R_FROM_DROP},
+    {swap_drop, OP_SWAP_DROP},
+#if SEF_NATIVE_CORE_WORDS
+    {two_dup, OP_TWO_DUP},
+    {two_drop, OP_TWO_DROP},
+    {nip, OP_NIP},
+    {over, OP_OVER},
+    {tuck, OP_TUCK},
+    {one_plus, OP_ONE_PLUS},
+    {one_minus, OP_ONE_MINUS},
+    {not_eq, OP_NOT_EQ},
+    {not_eq0, OP_NOT_EQ0},
+    {greater_than, OP_GREATER_THAN},
+    {greater0, OP_GREATER0},
+    {max, OP_MAX},
+    {min, OP_MIN},
+    {negate, OP_NEGATE},
+    {invert, OP_INVERT},
+    {plus_store, OP_PLUS_STORE},
+    {cell_plus, OP_CELL_PLUS},
+#endif
+};
+
+// Return the opcode of a C function, OP_CFUNC if it has no dedicated
+// implementation.
+static sef_int_t opcode_of_cfunc(cfunc func) {
+    for (size_t i = 0; i < sizeof(c_func_opcodes) / sizeof(struct c_func_opcode_s); i++) {
+        if (c_func_opcodes[i].func == func) {
+            return c_func_opcodes[i].opcode;
+        }
+    }
+    return OP_CFUNC;
+}
+
+#if SEF_DIRECT_THREADING
+// Inner interpreter where all the primitives are labels of a single function.
+// Executing a word is an indirect jump through the opcode in its code field
+// instead of the chain of calls made by sef_call_entry. As in the portable
+// engine, the code pointer points to the cell being executed and is moved to
+// the next cell after each word. The engine stops when it becomes NULL, which
+// happens when the outermost word exits or when the state aborts.
+void sef_threaded_run(forth_state_t* fs) {
+    static const void* const dispatch[OP_COUNT] = {
+        [OP_CFUNC] = &&cfunc_label,
+        [OP_DOCOL] = &&docol_label,
+        [OP_DOCREATE] = &&docreate_label,
+        [OP_DODOES] = &&dodoes_label,
+#if SEF_JIT_ENABLED
+        [OP_DONATIVE] = &&donative_label,
+#endif
+#if SEF_SHARED_DICTIONARY
+        [OP_DOSHAREDCREATE] = &&dosharedcreate_label,
+        [OP_DOSHAREDDOES] = &&doshareddoes_label,
+#endif
+        [OP_SWAP] = &&swap_label,
+        [OP_ROT] = &&rot_label,
+        [OP_DUP] = &&dup_word_label,
+        [OP_DROP] = &&drop_label,
+        [OP_TO_R] = &&to_r_label,
+        [OP_R_FROM] = &&r_from_label,
+        [OP_ADD] = &&add_label,
+        [OP_SUB] = &&sub_label,
+        [OP_MULT] = &&mult_label,
+        [OP_LESS_THAN] = &&less_than_label,
+        [OP_U_LESS_THAN] = &&u_less_than_label,
+        [OP_LESS0] = &&less0_label,
+        [OP_EQ0] = &&eq0_label,
+        [OP_EQ] = &&eq_label,
+        [OP_AND] = &&and_label,
+        [OP_OR] = &&or_label,
+        [OP_XOR] = &&xor_label,
+        [OP_LSHIFT] = &&lshift_label,
+        [OP_RSHIFT] = &&rshift_label,
+        [OP_TWO_SLASH] = &&two_slash_label,
+        [OP_ZERO_BRANCH] = &&zero_branch_label,
+        [OP_BRANCH] = &&branch_label,
+        [OP_QUESTION_DO] = &&question_do_run_time_label,
+        [OP_DO] = &&do_run_time_label,
+        [OP_PLUS_LOOP] = &&plus_loop_run_time_label,
+        [OP_LOOP] = &&loop_run_time_label,
+        [OP_I] = &&i_word_label,
+        [OP_J] = &&j_word_label,
+        [OP_UNLOOP] = &&unloop_label,
+        [OP_LEAVE] = &&leave_label,
+        [OP_OF] = &&of_run_time_label,
+        [OP_LITERAL] = &&literal_label,
+        [OP_CELLS] = &&cells_label,
+        [OP_FETCH] = &&fetch_label,
+        [OP_STORE] = &&store_label,
+        [OP_CFETCH] = &&cfetch_label,
+        [OP_CSTORE] = &&cstore_label,
+        [OP_EXIT] = &&exit_word_label,
+        [OP_EXECUTE] = &&execute_label,
+        [OP_LITERAL_ADD] = &&literal_add_label,
+        [OP_DUP_ZERO_BRANCH] = &&dup_zero_branch_label,
+        [OP_EQ0_ZERO_BRANCH] = &&eq0_zero_branch_label,
+        [OP_OVER_OVER] = &&over_over_label,
+        [OP_R_FROM_DROP] = &&r_from_drop_label,
+        [OP_SWAP_DROP] = &&swap_drop_label,
+#if SEF_NATIVE_CORE_WORDS
+        [OP_TWO_DUP] = &&two_dup_label,
+        [OP_TWO_DROP] = &&two_drop_label,
+        [OP_NIP] = &&nip_label,
+        [OP_OVER] = &&over_label,
+        [OP_TUCK] = &&tuck_label,
+        [OP_ONE_PLUS] = &&one_plus_label,
+        [OP_ONE_MINUS] = &&one_minus_label,
+        [OP_NOT_EQ] = &&not_eq_label,
+        [OP_NOT_EQ0] = &&not_eq0_label,
+        [OP_GREATER_THAN] = &&greater_than_label,
+        [OP_GREATER0] = &&greater0_label,
+        [OP_MAX] = &&max_label,
+        [OP_MIN] = &&min_label,
+        [OP_NEGATE] = &&negate_label,
+        [OP_INVERT] = &&invert_label,
+        [OP_PLUS_STORE] = &&plus_store_label,
+        [OP_CELL_PLUS] = &&cell_plus_label,
+#endif
+    };
+    dictionary_entry_t current;
+
+#if SEF_PROFILE_PAIRS
+#define PROFILE_DISPATCH(entry) sef_profile_dispatch(entry)
+#else
+#define PROFILE_DISPATCH(entry)
+#endif
+
+#if SEF_STACK_CACHING
+    // Registers of the engine. The top of the data stack is kept in `tos` and
+    // the cells under it are in memory, up to `sp` excluded. This means that
+    // the depth of the data stack, `tos` included, is `sp - fs->data_stack` and
+    // that the cell under `tos` is `sp[-2]`. When the data stack is empty,
+    // `tos` is spilled into the guard cell under it. `rp` points to the first
+    // free cell of the return stack. The registers are saved into the state
+    // before calling any C function and loaded back after it.
+    sef_int_t* ip;
+    sef_int_t* sp;
+    sef_int_t* rp;
+    sef_int_t tos;
+    sef_int_t opcode;
+
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+    // Number of cells each word takes from and puts on the stacks.
+    static const struct {
+        uint8_t data_in, data_out, return_in, return_out;
+    } stack_effects[OP_COUNT] = {
+        [OP_DOCOL] = {0, 0, 0, 1},
+        [OP_DOCREATE] = {0, 1, 0, 0},
+        [OP_DODOES] = {0, 1, 0, 1},
+#if SEF_JIT_ENABLED
+        [OP_DONATIVE] = {0, 0, 0, 1},
+#endif
+#if SEF_SHARED_DICTIONARY
+        [OP_DOSHAREDCREATE] = {0, 1, 0, 0},
+        [OP_DOSHAREDDOES] = {0, 1, 0, 1},
+#endif
+        [OP_SWAP] = {2, 2, 0, 0},
+        [OP_ROT] = {3, 3, 0, 0},
+        [OP_DUP] = {1, 2, 0, 0},
+        [OP_DROP] = {1, 0, 0, 0},
+        [OP_TO_R] = {1, 0, 0, 1},
+        [OP_R_FROM] = {0, 1, 1, 0},
+        [OP_ADD] = {2, 1, 0, 0},
+        [OP_SUB] = {2, 1, 0, 0},
+        [OP_MULT] = {2, 1, 0, 0},
+        [OP_LESS_THAN] = {2, 1, 0, 0},
+        [OP_U_LESS_THAN] = {2, 1, 0, 0},
+        [OP_LESS0] = {1, 1, 0, 0},
+        [OP_EQ0] = {1, 1, 0, 0},
+        [OP_EQ] = {2, 1, 0, 0},
+        [OP_AND] = {2, 1, 0, 0},
+        [OP_OR] = {2, 1, 0, 0},
+        [OP_XOR] = {2, 1, 0, 0},
+        [OP_LSHIFT] = {2, 1, 0, 0},
+        [OP_RSHIFT] = {2, 1, 0, 0},
+        [OP_TWO_SLASH] = {1, 1, 0, 0},
+        [OP_ZERO_BRANCH] = {1, 0, 0, 0},
+        [OP_BRANCH] = {0, 0, 0, 0},
+        [OP_QUESTION_DO] = {2, 0, 0, 3},
+        [OP_DO] = {2, 0, 0, 3},
+        [OP_PLUS_LOOP] = {1, 0, 3, 3},
+        [OP_LOOP] = {0, 0, 3, 3},
+        [OP_I] = {0, 1, 1, 1},
+        [OP_J] = {0, 1, 4, 4},
+        [OP_UNLOOP] = {0, 0, 3, 0},
+        [OP_LEAVE] = {0, 0, 3, 0},
+        [OP_OF] = {2, 1, 0, 0},
+        [OP_LITERAL] = {0, 1, 0, 0},
+        [OP_CELLS] = {1, 1, 0, 0},
+        [OP_FETCH] = {1, 1, 0, 0},
+        [OP_STORE] = {2, 0, 0, 0},
+        [OP_CFETCH] = {1, 1, 0, 0},
+        [OP_CSTORE] = {2, 0, 0, 0},
+        [OP_EXIT] = {0, 0, 1, 0},
+        [OP_EXECUTE] = {1, 0, 0, 0},
+        [OP_LITERAL_ADD] = {1, 1, 0, 0},
+        [OP_DUP_ZERO_BRANCH] = {1, 1, 0, 0},
+        [OP_EQ0_ZERO_BRANCH] = {1, 0, 0, 0},
+        [OP_OVER_OVER] = {2, 4, 0, 0},
+        [OP_R_FROM_DROP] = {0, 0, 1, 0},
+        [OP_SWAP_DROP] = {2, 1, 0, 0},
+#if SEF_NATIVE_CORE_WORDS
+        [OP_TWO_DUP] = {2, 4, 0, 0},
+        [OP_TWO_DROP] = {2, 0, 0, 0},
+        [OP_NIP] = {2, 1, 0, 0},
+        [OP_OVER] = {2, 3, 0, 0},
+        [OP_TUCK] = {2, 3, 0, 0},
+        [OP_ONE_PLUS] = {1, 1, 0, 0},
+        [OP_ONE_MINUS] = {1, 1, 0, 0},
+        [OP_NOT_EQ] = {2, 1, 0, 0},
+        [OP_NOT_EQ0] = {1, 1, 0, 0},
+        [OP_GREATER_THAN] = {2, 1, 0, 0},
+        [OP_GREATER0] = {1, 1, 0, 0},
+        [OP_MAX] = {2, 1, 0, 0},
+        [OP_MIN] = {2, 1, 0, 0},
+        [OP_NEGATE] = {1, 1, 0, 0},
+        [OP_INVERT] = {1, 1, 0, 0},
+        [OP_PLUS_STORE] = {2, 0, 0, 0},
+        [OP_CELL_PLUS] = {1, 1, 0, 0},
+#endif
+    };
+#endif
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+    // The sizes of the stacks are kept in registers too.
+    const bool guarded = SEF_HAS_GUARD_PAGES(fs);
+    const sef_int_t data_stack_size = fs->data_stack_size;
+    const sef_int_t return_stack_size = fs->return_stack_size;
+#endif
+
+#define LOAD_REGISTERS()                                   \
+    ip = fs->code_pointer;                                 \
+    sp = &fs->data_stack[fs->data_stack_index];            \
+    rp = &fs->return_stack[fs->return_stack_index];        \
+    tos = sp[-1]
+
+#define SAVE_REGISTERS()                                   \
+    fs->code_pointer = ip;                                 \
+    sp[-1] = tos;                                          \
+    fs->data_stack_index = sp - fs->data_stack;            \
+    fs->return_stack_index = rp - fs->return_stack
+
+// Primitives don't check the stacks. Instead, the stacks are checked once
+// before dispatching a word, against the number of cells the word takes from
+// and puts on them. C functions check the stacks themselves.
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+#define CHECK_STACK(pointer, stack_name, stack_size, in, out)                                   \
+    if ((sef_unsigned_t) (pointer - fs->stack_name ## _stack - (in)) >= (sef_unsigned_t) ((stack_size) - (out))) { \
+        SAVE_REGISTERS();                                                                       \
+        SEF_ERROR_OUT(fs, "Stack '%s' out of bound. Resetting state.\n", #stack_name);          \
+        return;                                                                                 \
+    }
+
+// With guard pages, the other overflows fault in them.
+#define CHECK_STACKS(opcode)                                                                                             \
+    if (SEF_DATA_UNDERFLOW_CHECKS && guarded) {                                                                          \
+        CHECK_STACK(sp, data, data_stack_size, stack_effects[opcode].data_in, 0)                                        \
+    } else if (SEF_STACK_INDEX_CHECKS) {                                                                                 \
+        CHECK_STACK(sp, data, data_stack_size, stack_effects[opcode].data_in, stack_effects[opcode].data_out)           \
+        CHECK_STACK(rp, return, return_stack_size, stack_effects[opcode].return_in, stack_effects[opcode].return_out)   \
+    }
+#else
+#define CHECK_STACKS(opcode)
+#endif
+
+// The words that might segfault save the registers first so that the segfault
+// handler can tell which word caused it and print a correct stack trace.
+#if SEF_CATCH_SEGFAULTS
+#define SAVE_REGISTERS_FOR_SEGFAULT() SAVE_REGISTERS()
+#else
+#define SAVE_REGISTERS_FOR_SEGFAULT()
+#endif
+
+// The sampling profiler reads the code pointer and the return stack index
+// from the state when its timer fires.
+#if SEF_SAMPLING_PROFILER
+#define SAVE_REGISTERS_FOR_SAMPLING()                  \
+    fs->code_pointer = ip;                             \
+    fs->return_stack_index = rp - fs->return_stack
+#else
+#define SAVE_REGISTERS_FOR_SAMPLING()
+#endif
+
+#define DISPATCH(entry)                          \
+    current = (entry);                           \
+    PROFILE_DISPATCH(current);                   \
+    SAVE_REGISTERS_FOR_SAMPLING();               \
+    opcode = *sef_get_entry_code_field(current); \
+    CHECK_STACKS(opcode);                        \
+    goto *dispatch[opcode]
+
+#define NEXT() DISPATCH((dictionary_entry_t) *++ip)
+
+// Calls a C function with the registers saved in the state. The state might
+// have been aborted by the function, in which case the engine stops.
+#define CALL_C(call)       \
+    SAVE_REGISTERS();      \
+    call;                  \
+    LOAD_REGISTERS();      \
+    if (ip == NULL) {      \
+        return;            \
+    }
+
+#define PUSH(value) {             \
+        sef_int_t pushed = value; \
+        sp[-1] = tos;             \
+        sp++;                     \
+        tos = pushed;             \
+    }
+
+#define POP_INTO(var, type) \
+    var = (type) tos;         \
+    sp--;                     \
+    tos = sp[-1]
+
+// Replaces the two cells at the top of the stack, `a` and `b`, with `expr`.
+#define BINARY(expr) {            \
+        sef_int_t a = sp[-2];     \
+        sef_int_t b = tos;        \
+        sp--;                     \
+        tos = (expr);             \
+    }
+
+    // A state that has quit does not run code, this is the only time this
+    // is checked.
+    if (fs->quit) {
+        fs->code_pointer = NULL;
+        return;
+    }
+    if (fs->code_pointer == NULL) {
+        return;
+    }
+    LOAD_REGISTERS();
+    DISPATCH((dictionary_entry_t) *ip);
+
+cfunc_label:
+    CALL_C(PROFILE_C_WORD(fs, current, sef_exec_cfunc(fs, sef_get_entry_parameter(current))));
+    NEXT();
+
+docol_label:
+    *rp++ = (sef_int_t) ip;
+    PROFILE_CALL(current, rp - fs->return_stack);
+    ip = sef_get_entry_parameter(current);
+    DISPATCH((dictionary_entry_t) *ip);
+
+docreate_label:
+    PUSH((sef_int_t) sef_get_entry_parameter(current));
+    NEXT();
+
+dodoes_label:
+    *rp++ = (sef_int_t) ip;
+    PROFILE_CALL(current, rp - fs->return_stack);
+    PUSH((sef_int_t) sef_get_entry_parameter(current));
+    ip = (sef_int_t*) *sef_get_entry_special_parameters(current); // Points to `DOES>`, NEXT moves to the code after it.
+    NEXT();
+
+#if SEF_SHARED_DICTIONARY
+dosharedcreate_label:
+    PUSH((sef_int_t) fs->forth_memory + *(sef_int_t*) sef_get_entry_parameter(current));
+    NEXT();
+
+doshareddoes_label:
+    *rp++ = (sef_int_t) ip;
+    PROFILE_CALL(current, rp - fs->return_stack);
+    PUSH((sef_int_t) fs->forth_memory + *(sef_int_t*) sef_get_entry_parameter(current));
+    ip = (sef_int_t*) *sef_get_entry_special_parameters(current);
+    NEXT();
+#endif
+
+#if SEF_JIT_ENABLED
+    // The machine code runs with the registers saved in the state and leaves
+    // them there.
+donative_label:
+    *rp++ = (sef_int_t) ip;
+    PROFILE_CALL(current, rp - fs->return_stack);
+    SAVE_REGISTERS();
+    if (!sef_jit_run(current)) {
+        return;
+    }
+    LOAD_REGISTERS();
+    ip = (sef_int_t*) *--rp;
+    PROFILE_RETURN(rp - fs->return_stack);
+    NEXT();
+#endif
+
+execute_label:
+    SAVE_REGISTERS_FOR_SEGFAULT();
+    POP_INTO(current, dictionary_entry_t);
+    DISPATCH(current);
+
+exit_word_label:
+    ip = (sef_int_t*) *--rp;
+    PROFILE_RETURN(rp - fs->return_stack);
+    if (ip == NULL) {
+        SAVE_REGISTERS();
+        return;
+    }
+    NEXT();
+
+swap_label: {
+        sef_int_t w = sp[-2];
+        sp[-2] = tos;
+        tos = w;
+        NEXT();
+    }
+
+rot_label: {
+        sef_int_t w = sp[-3];
+        sp[-3] = sp[-2];
+        sp[-2] = tos;
+        tos = w;
+        NEXT();
+    }
+
+dup_word_label:
+    sp[-1] = tos;
+    sp++;
+    NEXT();
+
+drop_label:
+    sp--;
+    tos = sp[-1];
+    NEXT();
+
+to_r_label:
+    *rp++ = tos;
+    sp--;
+    tos = sp[-1];
+    NEXT();
+
+r_from_label:
+    PUSH(*--rp);
+    NEXT();
+
+add_label:
+    BINARY(a + b);
+    NEXT();
+
+sub_label:
+    BINARY(a - b);
+    NEXT();
+
+mult_label:
+    BINARY(a * b);
+    NEXT();
+
+less_than_label:
+    BINARY(FORTH_BOOL(a < b));
+    NEXT();
+
+u_less_than_label:
+    BINARY(FORTH_BOOL((sef_unsigned_t) a < (sef_unsigned_t) b));
+    NEXT();
+
+eq_label:
+    BINARY(FORTH_BOOL(a == b));
+    NEXT();
+
+and_label:
+    BINARY(a & b);
+    NEXT();
+
+or_label:
+    BINARY(a | b);
+    NEXT();
+
+xor_label:
+    BINARY(a ^ b);
+    NEXT();
+
+lshift_label:
+    BINARY(a << b);
+    NEXT();
+
+rshift_label:
+    BINARY((sef_int_t) ((sef_unsigned_t) a >> (sef_unsigned_t) b));
+    NEXT();
+
+less0_label:
+    tos = FORTH_BOOL(tos < 0);
+    NEXT();
+
+eq0_label:
+    tos = FORTH_BOOL(tos == 0);
+    NEXT();
+
+two_slash_label:
+    tos = tos >> 1;
+    NEXT();
+
+cells_label:
+    tos = tos * sizeof(sef_int_t);
+    NEXT();
+
+literal_label:
+    PUSH(*++ip);
+    NEXT();
+
+fetch_label:
+    SAVE_REGISTERS_FOR_SEGFAULT();
+    tos = *(sef_int_t*) tos;
+    NEXT();
+
+store_label:
+    SAVE_REGISTERS_FOR_SEGFAULT();
+    *(sef_int_t*) tos = sp[-2];
+    sp -= 2;
+    tos = sp[-1];
+    NEXT();
+
+cfetch_label:
+    SAVE_REGISTERS_FOR_SEGFAULT();
+    tos = (sef_int_t) *(char*) tos;
+    NEXT();
+
+cstore_label:
+    SAVE_REGISTERS_FOR_SEGFAULT();
+    *(char*) tos = (char) sp[-2];
+    sp -= 2;
+    tos = sp[-1];
+    NEXT();
+
+zero_branch_label: {
+        sef_int_t flag = tos;
+        sp--;
+        tos = sp[-1];
+        if (!flag) {
+            ip = (sef_int_t*) ip[1];
+        } else {
+            ip++;
+        }
+        NEXT();
+    }
+
+branch_label:
+    ip = (sef_int_t*) ip[1];
+    NEXT();
+
+of_run_time_label: {
+        sef_int_t reference = tos;
+        sef_int_t element = sp[-2];
+        if (reference != element) {
+            sp--;
+            tos = element;
+            ip = (sef_int_t*) ip[1];
+        } else {
+            sp -= 2;
+            tos = sp[-1];
+            ip++;
+        }
+        NEXT();
+    }
+
+question_do_run_time_label:
+    if (sp[-2] == tos) {
+        ip = (sef_int_t*) ip[1];
+        sp -= 2;
+        tos = sp[-1];
+        NEXT();
+    }
+    // Otherwise, the loop-sys is prepared as in do
+do_run_time_label:
+    rp[0] = ip[1];  // End of loop address
+    rp[1] = sp[-2]; // End value
+    rp[2] = tos;    // Loop counter
+    rp += 3;
+    sp -= 2;
+    tos = sp[-1];
+    ip++;
+    NEXT();
+
+loop_run_time_label:
+    if (++rp[-1] == rp[-2]) {
+        rp -= 3;
+        ip++;
+    } else {
+        ip = (sef_int_t*) ip[1];
+    }
+    NEXT();
+
+plus_loop_run_time_label: {
+        sef_int_t increment;
+        POP_INTO(increment, sef_int_t);
+        sef_int_t old_loop_counter = rp[-1];
+        sef_int_t end_value = rp[-2];
+
+        sef_int_t min_int = ((sef_unsigned_t) ~0 >> 1) + 1;
+        sef_int_t check_sign_before = (old_loop_counter - end_value) + min_int;
+        sef_int_t check_sign_after = check_sign_before + increment;
+        bool overflowed = increment > 0 && check_sign_after < check_sign_before;
+        bool underflowed = increment < 0 && check_sign_after > check_sign_before;
+        if (overflowed || underflowed) {
+            rp -= 3;
+            ip++;
+        } else {
+            rp[-1] = old_loop_counter + increment;
+            ip = (sef_int_t*) ip[1];
+        }
+        NEXT();
+    }
+
+i_word_label:
+    PUSH(rp[-1]);
+    NEXT();
+
+j_word_label:
+    PUSH(rp[-4]);
+    NEXT();
+
+unloop_label:
+    rp -= 3;
+    NEXT();
+
+leave_label:
+    ip = (sef_int_t*) rp[-3];
+    rp -= 3;
+    NEXT();
+
+literal_add_label:
+    tos += ip[1];
+    ip += 2;
+    NEXT();
+
+dup_zero_branch_label:
+    if (!tos) {
+        ip = (sef_int_t*) ip[2];
+    } else {
+        ip += 2;
+    }
+    NEXT();
+
+eq0_zero_branch_label: {
+        sef_int_t flag = tos;
+        sp--;
+        tos = sp[-1];
+        if (flag) {
+            ip = (sef_int_t*) ip[2];
+        } else {
+            ip += 2;
+        }
+        NEXT();
+    }
+
+over_over_label:
+    sp[-1] = tos;
+    sp[0] = sp[-2];
+    sp += 2;
+    ip++;
+    NEXT();
+
+r_from_drop_label:
+    rp--;
+    ip++;
+    NEXT();
+
+swap_drop_label:
+    sp--;
+    ip++;
+    NEXT();
+
+#if SEF_NATIVE_CORE_WORDS
+two_dup_label:
+    sp[-1] = tos;
+    sp[0] = sp[-2];
+    sp += 2;
+    NEXT();
+
+two_drop_label:
+    sp -= 2;
+    tos = sp[-1];
+    NEXT();
+
+nip_label:
+    sp--;
+    NEXT();
+
+over_label:
+    sp[-1] = tos;
+    tos = sp[-2];
+    sp++;
+    NEXT();
+
+tuck_label:
+    sp[-1] = sp[-2];
+    sp[-2] = tos;
+    sp++;
+    NEXT();
+
+one_plus_label:
+    tos++;
+    NEXT();
+
+one_minus_label:
+    tos--;
+    NEXT();
+
+not_eq_label:
+    BINARY(FORTH_BOOL(a != b));
+    NEXT();
+
+not_eq0_label:
+    tos = FORTH_BOOL(tos != 0);
+    NEXT();
+
+greater_than_label:
+    BINARY(FORTH_BOOL(a > b));
+    NEXT();
+
+greater0_label:
+    tos = FORTH_BOOL(tos > 0);
+    NEXT();
+
+max_label:
+    BINARY(a < b ? b : a);
+    NEXT();
+
+min_label:
+    BINARY(a < b ? a : b);
+    NEXT();
+
+negate_label:
+    tos = -tos;
+    NEXT();
+
+invert_label:
+    tos = ~tos;
+    NEXT();
+
+plus_store_label:
+    SAVE_REGISTERS_FOR_SEGFAULT();
+    *(sef_int_t*) tos += sp[-2];
+    sp -= 2;
+    tos = sp[-1];
+    NEXT();
+
+cell_plus_label:
+    tos += sizeof(sef_int_t);
+    NEXT();
+#endif
+
+#undef BINARY
+#undef POP_INTO
+#undef PUSH
+#undef CALL_C
+#undef SAVE_REGISTERS_FOR_SEGFAULT
+#undef SAVE_REGISTERS_FOR_SAMPLING
+#undef CHECK_STACKS
+#undef SAVE_REGISTERS
+#undef LOAD_REGISTERS
+#else
+
+#define DISPATCH(entry)          \
+    current = (entry);           \
+    PROFILE_DISPATCH(current);   \
+    goto *dispatch[*sef_get_entry_code_field(current)]
+
+#define NEXT()                                          \
+    if (fs->code_pointer == NULL) {                     \
+        return;                                         \
+    }                                                   \
+    fs->code_pointer++;                                 \
+    DISPATCH((dictionary_entry_t) *fs->code_pointer)
+
+#define PRIMITIVE(func) \
+func ## _label:         \
+    func(fs);           \
+    NEXT()
+
+    if (fs->code_pointer == NULL) {
+        return;
+    }
+    DISPATCH((dictionary_entry_t) *fs->code_pointer);
+
+cfunc_label:
+    PROFILE_C_WORD(fs, current, sef_exec_cfunc(fs, sef_get_entry_parameter(current)));
+    NEXT();
+
+docol_label:
+    sef_push_return(fs, (sef_int_t) fs->code_pointer);
+    if (fs->code_pointer == NULL) {
+        return;
+    }
+    PROFILE_CALL(current, fs->return_stack_index);
+    fs->code_pointer = sef_get_entry_parameter(current);
+    DISPATCH((dictionary_entry_t) *fs->code_pointer);
+
+docreate_label:
+    sef_exec_create(fs, sef_get_entry_parameter(current));
+    NEXT();
+
+dodoes_label:
+    sef_push_return(fs, (sef_int_t) fs->code_pointer);
+    sef_push_data(fs, (sef_int_t) sef_get_entry_parameter(current));
+    if (fs->code_pointer == NULL) {
+        return;
+    }
+    PROFILE_CALL(current, fs->return_stack_index);
+    fs->code_pointer = (sef_int_t*) *sef_get_entry_special_parameters(current); // Points to `DOES>`, NEXT moves to the code after it.
+    NEXT();
+
+#if SEF_SHARED_DICTIONARY
+dosharedcreate_label:
+    sef_exec_create(fs, sef_get_entry_body(fs, current));
+    NEXT();
+
+doshareddoes_label:
+    sef_push_return(fs, (sef_int_t) fs->code_pointer);
+    sef_push_data(fs, (sef_int_t) sef_get_entry_body(fs, current));
+    if (fs->code_pointer == NULL) {
+        return;
+    }
+    PROFILE_CALL(current, fs->return_stack_index);
+    fs->code_pointer = (sef_int_t*) *sef_get_entry_special_parameters(current);
+    NEXT();
+#endif
+
+#if SEF_JIT_ENABLED
+donative_label:
+    sef_push_return(fs, (sef_int_t) fs->code_pointer);
+    PROFILE_CALL(current, fs->return_stack_index);
+    if (!sef_jit_run(current)) {
+        return;
+    }
+    sef_exit(fs);
+    NEXT();
+#endif
+
+execute_label:
+    current = (dictionary_entry_t) sef_pop_data(fs);
+    if (fs->code_pointer == NULL) {
+        return;
+    }
+    DISPATCH(current);
+
+    PRIMITIVE(swap);
+    PRIMITIVE(rot);
+    PRIMITIVE(dup_word);
+    PRIMITIVE(drop);
+    PRIMITIVE(to_r);
+    PRIMITIVE(r_from);
+    PRIMITIVE(add);
+    PRIMITIVE(sub);
+    PRIMITIVE(mult);
+    PRIMITIVE(less_than);
+    PRIMITIVE(u_less_than);
+    PRIMITIVE(less0);
+    PRIMITIVE(eq0);
+    PRIMITIVE(eq);
+    PRIMITIVE(and);
+    PRIMITIVE(or);
+    PRIMITIVE(xor);
+    PRIMITIVE(lshift);
+    PRIMITIVE(rshift);
+    PRIMITIVE(two_slash);
+    PRIMITIVE(zero_branch);
+    PRIMITIVE(branch);
+    PRIMITIVE(question_do_run_time);
+    PRIMITIVE(do_run_time);
+    PRIMITIVE(plus_loop_run_time);
+    PRIMITIVE(loop_run_time);
+    PRIMITIVE(i_word);
+    PRIMITIVE(j_word);
+    PRIMITIVE(unloop);
+    PRIMITIVE(leave);
+    PRIMITIVE(of_run_time);
+    PRIMITIVE(literal);
+    PRIMITIVE(cells);
+    PRIMITIVE(fetch);
+    PRIMITIVE(store);
+    PRIMITIVE(cfetch);
+    PRIMITIVE(cstore);
+    PRIMITIVE(exit_word);
+    PRIMITIVE(literal_add);
+    PRIMITIVE(dup_zero_branch);
+    PRIMITIVE(eq0_zero_branch);
+    PRIMITIVE(over_over);
+    PRIMITIVE(r_from_drop);
+    PRIMITIVE(swap_drop);
+#if SEF_NATIVE_CORE_WORDS
+    PRIMITIVE(two_dup);
+    PRIMITIVE(two_drop);
+    PRIMITIVE(nip);
+    PRIMITIVE(over);
+    PRIMITIVE(tuck);
+    PRIMITIVE(one_plus);
+    PRIMITIVE(one_minus);
+    PRIMITIVE(not_eq);
+    PRIMITIVE(not_eq0);
+    PRIMITIVE(greater_than);
+    PRIMITIVE(greater0);
+    PRIMITIVE(max);
+    PRIMITIVE(min);
+    PRIMITIVE(negate);
+    PRIMITIVE(invert);
+    PRIMITIVE(plus_store);
+    PRIMITIVE(cell_plus);
+#endif
+
+#undef PRIMITIVE
+#endif
+#undef NEXT
+#undef DISPATCH
+#undef PROFILE_DISPATCH
+}
+#endif
@@ -2,14 +2,111 @@
 #ifndef C_FUNC_H
 #define C_FUNC_H
 
+typedef void (*cfunc)(forth_state_t*);
+
 // Add a new word defined in C into the dictionary. name must be NULL terminated.
 void sef_register_cfunc(forth_state_t* fs, const char* name, void (*func)(forth_state_t*), bool is_imediate);
 
 // Register run-time system words defined in C.
 void sef_register_default_cfunc(forth_state_t* fs);
 
+// Return the name of the run-time system word at the given index of its table
+// and set `func` to its function, or return NULL past the end of the table.
+const char* sef_default_cfunc_at(size_t index, cfunc* func);
+
 // Execute a C function
 void sef_exec_cfunc(forth_state_t* fs, void* parameters);
 
+// Operation codes stored in the code field of dictionary entries. The threaded
+// engine jumps straight to the implementation matching the code.
+enum sef_opcode {
+    // Generic kinds of words
+    OP_CFUNC,
+    OP_DOCOL,
+    OP_DOCREATE,
+    OP_DODOES,
+#if SEF_JIT_ENABLED
+    OP_DONATIVE,
+#endif
+#if SEF_SHARED_DICTIONARY
+    OP_DOSHAREDCREATE,
+    OP_DOSHAREDDOES,
+#endif
+    // C words with a dedicated implementation in the threaded engine
+    OP_SWAP,
+    OP_ROT,
+    OP_DUP,
+    OP_DROP,
+    OP_TO_R,
+    OP_R_FROM,
+    OP_ADD,
+    OP_SUB,
+    OP_MULT,
+    OP_LESS_THAN,
+    OP_U_LESS_THAN,
+    OP_LESS0,
+    OP_EQ0,
+    OP_EQ,
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_LSHIFT,
+    OP_RSHIFT,
+    OP_TWO_SLASH,
+    OP_ZERO_BRANCH,
+    OP_BRANCH,
+    OP_QUESTION_DO,
+    OP_DO,
+    OP_PLUS_LOOP,
+    OP_LOOP,
+    OP_I,
+    OP_J,
+    OP_UNLOOP,
+    OP_LEAVE,
+    OP_OF,
+    OP_LITERAL,
+    OP_CELLS,
+    OP_FETCH,
+    OP_STORE,
+    OP_CFETCH,
+    OP_CSTORE,
+    OP_EXIT,
+    OP_EXECUTE,
+    // Superinstructions
+    OP_LITERAL_ADD,
+    OP_DUP_ZERO_BRANCH,
+    OP_EQ0_ZERO_BRANCH,
+    OP_OVER_OVER,
+    OP_R_FROM_DROP,
+    OP_SWAP_DROP,
+#if SEF_NATIVE_CORE_WORDS
+    // Native core words
+    OP_TWO_DUP,
+    OP_TWO_DROP,
+    OP_NIP,
+    OP_OVER,
+    OP_TUCK,
+    OP_ONE_PLUS,
+    OP_ONE_MINUS,
+    OP_NOT_EQ,
+    OP_NOT_EQ0,
+    OP_GREATER_THAN,
+    OP_GREATER0,
+    OP_MAX,
+    OP_MIN,
+    OP_NEGATE,
+    OP_INVERT,
+    OP_PLUS_STORE,
+    OP_CELL_PLUS,
+#endif
+
+    OP_COUNT,
+};
+
+#if SEF_DIRECT_THREADING
+// Run the words from the code pointer until it becomes NULL.
+void sef_threaded_run(forth_state_t* fs);
+#endif
+
 #endif
 
@@ -30,6 +30,8 @@ typedef SEF_UNSIGNED_T sef_unsigned_t;
 
 £define ___SEF_ARG_AND_EXIT_CODE SEF_ARG_AND_EXIT_CODE
 
+£define ___SEF_SEARCH_ORDER SEF_SEARCH_ORDER
+
 >> ------------------------------- Memory used ------------------------------ >>
 
 >> Number of cells in the return stack.
@@ -48,6 +50,11 @@ typedef SEF_UNSIGNED_T sef_unsigned_t;
 >> Size in bytes of the pad region.
 £define ___SEF_PAD_SIZE SEF_PAD_SIZE
 
+>> Number of lists in the hash index used to find words in the dictionary. Each
+>> of them takes a cell in the Forth state. With more words than lists, finding
+>> a word gets slower.
+£define ___SEF_DICTIONARY_BUCKETS SEF_DICTIONARY_BUCKETS
+
 #if SEF_BLOCK
 >> Number of block buffer available. They are stored in the memory indexed by
 >> HERE.
@@ -82,14 +89,152 @@ typedef SEF_UNSIGNED_T sef_unsigned_t;
 £define ___SEF_STACK_BOUND_CHECKS SEF_STACK_BOUND_CHECKS
 
 >> With this option set to 1, segfaults caused by Forth code will be caught and
->> the interpreter will be put back into an idle state if encountered. This
->> relies on static variable and thus, this prevent the interpreter to be used
->> on multiple threads. Furthermore, the system running SEForth needs to
->> support POSIX signals.
+>> the interpreter will be put back into an idle state if encountered. The
+>> recovery point is kept per thread, so states can run on different threads,
+>> and the segfaults that don't come from Forth code are given to the handler
+>> installed before, if any. Furthermore, the system running SEForth needs to
+>> support POSIX signals. The signal handler is installed by `sef_init` and
+>> recovery is armed once per call to `sef_eval_string`, so it costs nothing
+>> when words are executed.
 £define ___SEF_CATCH_SEGFAULTS SEF_CATCH_SEGFAULTS
 
+>> If set to 1, words are executed by a single dispatch loop where each
+>> primitive is a label and where dispatching a word is an indirect jump. This is
+>> much faster but requires the labels-as-values extension of GCC and Clang. If
+>> set to 0, a portable engine that calls each word through a function pointer
+>> is used.
+£define ___SEF_DIRECT_THREADING SEF_DIRECT_THREADING
+
+>> If set to 1 and the threaded engine is used, the top of the data stack is
+>> kept in a register of the engine and the primitives work on the stacks
+>> without checking them; stack bounds are checked once before each word is
+>> dispatched. This makes arithmetic-heavy code faster. If set to 0, the
+>> threaded engine executes the primitives through the same functions as the
+>> portable engine.
+£define ___SEF_STACK_CACHING SEF_STACK_CACHING
+
+>> If set to 1, some frequent sequences of words, such as `dup if` or `over
+>> over`, are replaced by a single superinstruction when they are compiled,
+>> which saves dispatching the words of the sequence one by one.
+£define ___SEF_SUPERINSTRUCTIONS SEF_SUPERINSTRUCTIONS
+
+>> If set to 1, the interpreter counts how many times each pair of words is
+>> executed one after the other, and the word `.pairs` prints the most frequent
+>> pairs. This is meant to find new sequences worth a superinstruction. It slows
+>> down the interpreter and, as it relies on static variables, prevents using it
+>> on multiple threads.
+£define ___SEF_PROFILE_PAIRS SEF_PROFILE_PAIRS
+
+>> If set to 1, the words `profile-start`, `profile-stop` and `profile-report`
+>> count the calls to each word and measure the time spent in it, with and
+>> without the words it calls, and print them sorted by the time spent in the
+>> word itself. The functions `sef_profile_start`, `sef_profile_stop` and
+>> `sef_get_profile` do the same from C. Primitives, words made with `create`
+>> and words that are inlined, tail-called or called from machine code are
+>> counted as part of the word running them. The clock is only read when a word
+>> returns, so the time a word runs before calling another one is counted in the
+>> word called, unless a word returned in between. Running, it does not stay
+>> under 10% of overhead: reading the clock once per call, about 20 ns, makes
+>> code calling a word every 30 ns about twice as slow and recursive code such
+>> as `fib` about 20% slower; `SEF_SAMPLING_PROFILER` is lighter for such code.
+>> A stopped profiler costs a test per call and per return. As it relies on
+>> static variables, it prevents using the interpreter on multiple threads.
+£define ___SEF_PROFILE SEF_PROFILE
+
+>> If set to 1, the functions `sef_start_sampling` and `sef_stop_sampling`, or
+>> the `--profile <file>` option of `seforth`, sample the words running with a
+>> `SIGPROF` timer and write the samples as folded stacks, which flame graph
+>> tools can read. Unlike `SEF_PROFILE`, calls are not counted, which keeps the
+>> loops measured undisturbed; the threaded engine only saves its code pointer
+>> and return stack index before each word. Words compiled by the JIT are seen
+>> from the last word they ran through the threaded engine. It needs POSIX
+>> signals and, as it relies on static variables, prevents using the interpreter
+>> on multiple threads.
+£define ___SEF_SAMPLING_PROFILER SEF_SAMPLING_PROFILER
+
+>> If set to 1, the most used core words, such as `over`, `2dup`, `1+`, `max`,
+>> `/` or `aligned`, are implemented in C. If set to 0, they are defined in
+>> Forth, which is slower but makes the interpreter a bit smaller.
+£define ___SEF_NATIVE_CORE_WORDS SEF_NATIVE_CORE_WORDS
+
+>> If set to 1, a call to a Forth word followed by `EXIT` or `;` is compiled as
+>> a jump, so that the word called returns directly to the caller of the word
+>> being defined. This saves a push and a pop of the return stack for each of
+>> those calls and lets tail-recursive words run in constant return stack
+>> space. The words skipped that way are missing from stack traces.
+£define ___SEF_TAIL_CALLS SEF_TAIL_CALLS
+
+>> If set to more than 0, a call to a colon definition of at most that many
+>> cells, not counting its `EXIT`, is replaced by a copy of its body when it is
+>> compiled. This is only done for words without branches or loops that don't
+>> use the return stack. The word `noinline` prevents it for the last word
+>> defined. The words inlined are missing from stack traces.
+£define ___SEF_INLINE_MAX_CELLS SEF_INLINE_MAX_CELLS
+
+>> If set to 1, colon definitions are simplified when they are finished.
+>> Arithmetic on literals, such as `3 4 + cells`, is done at compile time, a
+>> literal compared to 0 uses `0=` and the like, and sequences doing nothing,
+>> such as `swap swap`, `dup drop` or `0 +`, are removed. The word
+>> `optimized-cells` gives the number of cells saved so far, which right after
+>> startup is what was saved on the system words.
+£define ___SEF_OPTIMIZER SEF_OPTIMIZER
+
+>> If set to 1, colon definitions are compiled to x86-64 machine code when they
+>> are finished. Words that can't be compiled, and words called from the machine
+>> code that have no template, are run by the threaded engine. This only works on
+>> x86-64 Linux with `SEF_DIRECT_THREADING` set to 1 and is ignored elsewhere. It
+>> maps a buffer of executable memory and relies on static variables, which
+>> prevents using it on multiple threads.
+£define ___SEF_JIT SEF_JIT
+
+>> If set to 1, the word `save-image` and the function `sef_save_image` write
+>> the dictionary and the memory addressed by HERE to a file, and
+>> `sef_load_image`, or the `--image <file>` option of `seforth`, start a state
+>> from such a file instead of compiling the system words. The C words of the
+>> system are bound again to the functions at the same place in the tables of C
+>> words, the other ones must be registered again with `sef_register_c_word`.
+>> Files, allocated memory and the block file are not kept in the image. It
+>> needs POSIX `mmap`.
+£define ___SEF_IMAGE SEF_IMAGE
+
+>> If set to 1, the system words are compiled when libseforth is built and
+>> `sef_init` copies the dictionary made then in the state, instead of compiling
+>> the Forth source of the system words, which makes starting much faster. The
+>> source is then not linked in the programs using the library, but the
+>> dictionary is bigger than it, around 34 kB against 6 kB on x86-64, so the
+>> programs get bigger. As a program built for the target runs during the
+>> build, set it to 0 when cross-compiling, which the Makefile then skips.
+>> `sef_system_words_compiled` is only called when this is set to 0.
+£define ___SEF_PRECOMPILED_DICTIONARY SEF_PRECOMPILED_DICTIONARY
+
+>> If set to 1, `sef_new_shared_dictionary` compiles the system words once in a
+>> read-only memory mapping, and `sef_init_shared` starts a state searching it
+>> after its own dictionary, instead of holding a copy of the system words.
+>> Only the bodies of the variables and values of the system, a few kB, are
+>> copied in the state. It needs POSIX `mmap`.
+£define ___SEF_SHARED_DICTIONARY SEF_SHARED_DICTIONARY
+
+>> If set to 1, `sef_create` maps a state whose memory addressed by HERE and
+>> stacks are sized at runtime, instead of the sizes set here, and `sef_destroy`
+>> unmaps it. Only the pages written are allocated, and the registers of the
+>> interpreter share the first cache line of the state. It needs POSIX `mmap`.
+£define ___SEF_MAPPED_STATES SEF_MAPPED_STATES
+
+>> If set to 1, each stack of the states made by `sef_create` is mapped between
+>> two guard pages that can't be accessed, and overflowing or underflowing it is
+>> caught by the segfault handler, which aborts the state as the bound checks
+>> do. The stacks are then only compared to their size for underflows of the
+>> data stack, as the threaded engine spills the top of an empty data stack in
+>> the cell under it, and they are made as big as their pages allow. The stacks
+>> of the states initialized by `sef_init`, `sef_load_image` or
+>> `sef_init_shared` have no guard pages and are still checked as set by
+>> `SEF_STACK_BOUND_CHECKS`, a test per word slowing down the states made by
+>> `sef_create` a bit. HERE is still checked if `SEF_STACK_BOUND_CHECKS` is set.
+>> It needs `SEF_MAPPED_STATES` and `SEF_CATCH_SEGFAULTS`.
+£define ___SEF_STACK_GUARD_PAGES SEF_STACK_GUARD_PAGES
+
 >> Size of the forth state
-£define SEF_STATE_SIZE_INT (1 + ((SEF_FORTH_MEMORY_SIZE / sizeof(sef_int_t)) + (SEF_PAD_SIZE / sizeof(sef_int_t)) + SEF_DATA_STACK_SIZE + SEF_RETURN_STACK_SIZE + SEF_CONTROL_FLOW_STACK_SIZE + 19 + 20))
+£define SEF_STATE_SIZE_INT (1 + ((SEF_FORTH_MEMORY_SIZE / sizeof(sef_int_t)) + (SEF_PAD_SIZE / sizeof(sef_int_t)) + SEF_DATA_STACK_SIZE + SEF_RETURN_STACK_SIZE + SEF_CONTROL_FLOW_STACK_SIZE + SEF_DICTIONARY_BUCKETS + (SEF_FORTH_MEMORY_SIZE / sizeof(sef_int_t) / 9) + 35 + 74 + 1))
 
 #if SEF_BLOCK
 >> If the block word set is enabled, setting this option to 1 lets the user of
@@ -0,0 +1,222 @@
+#include "SEForth.h"
+#include "string.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "stdbool.h"
+#include "time.h"
+
+// Runs the workloads given as arguments against libseforth. Each workload is
+// a Forth file defining `bench-ops ( -- n )`, the number of operations done by
+// one call to `bench ( -- )`. After a warm-up call, `bench` is timed several
+// times and the median time per operation is reported as text and, if asked,
+// as JSON. That JSON can be used as a baseline for later runs.
+//
+// Usage: bench.bin [--runs N] [--json FILE] [--baseline FILE] [--threshold %]
+//                  workload.frt...
+
+#define MAX_WORKLOADS 64
+#define MAX_RUNS 101
+#define MAX_NAME 64
+#define BLOCK_FILE "bench-blocks.tmp"
+#define BLOCKS_IN_FILE 32
+
+struct result_s {
+    char name[MAX_NAME];
+    long ops;
+    int runs;
+    double median_ns_per_op;
+    double min_ns_per_op;
+    double max_ns_per_op;
+    bool skipped;
+};
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0L, SEEK_END);
+    size_t file_size = ftell(f);
+    rewind(f);
+    char* content = malloc(file_size + 1);
+    if (content != NULL) {
+        content[fread(content, 1, file_size, f)] = 0;
+    }
+    fclose(f);
+    return content;
+}
+
+static void workload_name(const char* path, char* name) {
+    const char* base = strrchr(path, '/');
+    base = base == NULL ? path : base + 1;
+    snprintf(name, MAX_NAME, "%.*s", (int) strcspn(base, "."), base);
+}
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// Load and time a workload. Return false if it couldn't be run.
+static bool run_workload(sef_forth_state_t* fs, const char* path, int runs, struct result_s* result) {
+    workload_name(path, result->name);
+    result->skipped = false;
+    char* content = read_file(path);
+    if (content == NULL) {
+        fprintf(stderr, "Can't read %s.\n", path);
+        return false;
+    }
+    if (strstr(content, "\\ requires: block") != NULL) {
+#if SEF_BLOCK && SEF_BLOCK_FILE
+        sef_init(fs);
+        sef_register_block_file(fs, BLOCK_FILE, BLOCKS_IN_FILE);
+#else
+        result->skipped = true;
+        free(content);
+        return true;
+#endif
+    } else {
+        sef_init(fs);
+    }
+    sef_eval_string(fs, content);
+    free(content);
+    sef_eval_string(fs, "bench-ops");
+    if (!sef_ready_to_run(fs)) {
+        fprintf(stderr, "Can't load %s.\n", path);
+        return false;
+    }
+    result->ops = sef_pop_from_data_stack(fs);
+    result->runs = runs;
+
+    double times[MAX_RUNS];
+    sef_eval_string(fs, "bench");
+    for (int i=0; i<runs; i++) {
+        double start = now_ns();
+        sef_eval_string(fs, "bench");
+        times[i] = now_ns() - start;
+    }
+    if (!sef_ready_to_run(fs)) {
+        fprintf(stderr, "%s failed while running.\n", path);
+        return false;
+    }
+    qsort(times, runs, sizeof(double), compare_doubles);
+    result->median_ns_per_op = times[runs / 2] / result->ops;
+    result->min_ns_per_op = times[0] / result->ops;
+    result->max_ns_per_op = times[runs - 1] / result->ops;
+    return true;
+}
+
+static bool write_json(const char* path, const struct result_s* results, int count) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+    fprintf(f, "{\n  \"benchmarks\": [");
+    bool first = true;
+    for (int i=0; i<count; i++) {
+        if (results[i].skipped) {
+            continue;
+        }
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"ops\": %ld, \"runs\": %d, \"median_ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f}",
+                first ? "" : ",", results[i].name, results[i].ops, results[i].runs,
+                results[i].median_ns_per_op, results[i].min_ns_per_op, results[i].max_ns_per_op);
+        first = false;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+// Find the median time per operation of a benchmark in a JSON file written by
+// write_json. Return a negative number if it is not there.
+static double baseline_of(const char* json, const char* name) {
+    char key[MAX_NAME + 16];
+    snprintf(key, sizeof(key), "\"name\": \"%.*s\"", MAX_NAME, name);
+    const char* entry = strstr(json, key);
+    if (entry == NULL) {
+        return -1;
+    }
+    const char* median = strstr(entry, "\"median_ns_per_op\":");
+    if (median == NULL) {
+        return -1;
+    }
+    return strtod(median + strlen("\"median_ns_per_op\":"), NULL);
+}
+
+int main(int argc, char** argv) {
+    int runs = 7;
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    double threshold = 10;
+    int first_workload = 1;
+    for (; first_workload < argc - 1 && strncmp(argv[first_workload], "--", 2) == 0; first_workload += 2) {
+        const char* option = argv[first_workload];
+        const char* value = argv[first_workload + 1];
+        if (strcmp(option, "--runs") == 0) {
+            runs = atoi(value);
+        } else if (strcmp(option, "--json") == 0) {
+            json_path = value;
+        } else if (strcmp(option, "--baseline") == 0) {
+            baseline_path = value;
+        } else if (strcmp(option, "--threshold") == 0) {
+            threshold = atof(value);
+        } else {
+            fprintf(stderr, "Unknown option %s.\n", option);
+            return 1;
+        }
+    }
+    int count = argc - first_workload;
+    if (count <= 0 || count > MAX_WORKLOADS || runs < 1 || runs > MAX_RUNS) {
+        fprintf(stderr, "Usage: %s [--runs N] [--json FILE] [--baseline FILE] [--threshold %%] workload.frt...\n", argv[0]);
+        return 1;
+    }
+
+    char* baseline = NULL;
+    if (baseline_path != NULL && (baseline = read_file(baseline_path)) == NULL) {
+        fprintf(stderr, "Can't read the baseline %s.\n", baseline_path);
+        return 1;
+    }
+
+    sef_forth_state_t* fs = malloc(sizeof(sef_forth_state_t));
+    static struct result_s results[MAX_WORKLOADS];
+    bool failed = false;
+    printf("%-20s %14s %14s %14s", "benchmark", "median ns/op", "min ns/op", "max ns/op");
+    printf(baseline != NULL ? " %10s\n" : "\n", "vs base");
+    for (int i=0; i<count; i++) {
+        struct result_s* result = &results[i];
+        if (!run_workload(fs, argv[first_workload + i], runs, result)) {
+            result->skipped = true;
+            failed = true;
+            continue;
+        }
+        if (result->skipped) {
+            printf("%-20s %14s\n", result->name, "skipped");
+            continue;
+        }
+        printf("%-20s %14.2f %14.2f %14.2f", result->name, result->median_ns_per_op, result->min_ns_per_op, result->max_ns_per_op);
+        double reference = baseline != NULL ? baseline_of(baseline, result->name) : -1;
+        if (reference > 0) {
+            double change = 100 * (result->median_ns_per_op - reference) / reference;
+            bool regressed = change > threshold;
+            printf(" %+9.1f%%%s", change, regressed ? "  REGRESSED" : "");
+            failed |= regressed;
+        }
+        printf("\n");
+    }
+    remove(BLOCK_FILE);
+
+    if (json_path != NULL && !write_json(json_path, results, count)) {
+        fprintf(stderr, "Can't write %s.\n", json_path);
+        failed = true;
+    }
+    free(baseline);
+    free(fs);
+    return failed ? 1 : 0;
+}
+
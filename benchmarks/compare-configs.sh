@@ -0,0 +1,55 @@
+#!/bin/sh
+
+# Build SEForth with two sets of CFLAGS and time the same Forth script with
+# both builds. Each build is made in its own temporary copy of the sources so
+# that the working tree is left untouched.
+# Usage: ./compare-configs.sh "<CFLAGS A>" "<CFLAGS B>" <script.frt> [runs]
+
+if [ $# -lt 3 ]
+then
+    echo "Usage: $0 \"<CFLAGS A>\" \"<CFLAGS B>\" <script.frt> [runs]" > /dev/stderr
+    exit 1
+fi
+
+cflags_a=$1
+cflags_b=$2
+script=$(realpath "$3")
+runs=${4:-5}
+sources=$(realpath "$(dirname "$0")/..")
+
+# Build the interpreter in a new directory with the given CFLAGS and print the
+# path of that directory.
+build () {
+    dir=$(mktemp -d)
+    cp "$sources"/*.c "$sources"/*.h "$sources"/*.frt "$sources"/Makefile "$dir"
+    if ! make -C "$dir" CFLAGS="$1" seforth.bin > /dev/null 2>&1
+    then
+        echo "Failed to build with CFLAGS=$1" > /dev/stderr
+        exit 1
+    fi
+    printf '%s' "$dir"
+}
+
+# Run the script with the given interpreter several times and print the median
+# run time in milliseconds.
+median_ms () {
+    i=0
+    while [ $i -lt "$runs" ]
+    do
+        start=$(date +%s%N)
+        "$1" "$script" > /dev/null < /dev/null
+        end=$(date +%s%N)
+        echo $(( (end - start) / 1000000 ))
+        i=$((i + 1))
+    done | sort -n | awk '{ t[NR] = $1 } END { print t[int((NR + 1) / 2)] }'
+}
+
+dir_a=$(build "$cflags_a") || exit 1
+dir_b=$(build "$cflags_b") || exit 1
+ms_a=$(median_ms "$dir_a/seforth.bin")
+ms_b=$(median_ms "$dir_b/seforth.bin")
+rm -rf "$dir_a" "$dir_b"
+
+echo "A ($cflags_a): $ms_a ms"
+echo "B ($cflags_b): $ms_b ms"
+awk -v a="$ms_a" -v b="$ms_b" 'BEGIN { if (b > 0) printf "A/B: %.2f\n", a / b }'
@@ -0,0 +1,233 @@
+#include "SEForth.h"
+#include "string.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "stdbool.h"
+#include "time.h"
+
+// Measures how fast libseforth reads source code. First, `sef_init` is timed
+// and, unless the dictionary is precompiled, the time spent on each set of
+// system words, such as `core_forth_words` or `tools_forth_words`, is reported.
+// Then, synthetic sources of the given numbers of lines are generated and
+// evaluated with `sef_eval_buffer` in a fresh state, and the lines and words
+// read per second, and the dictionary entries compared per word, are reported.
+// As reading a source is linear in its size, the lines read per second should
+// not drop for bigger sources. The sources define many words, which call the
+// ones defined before them, and use many literals, which are looked up in the
+// whole dictionary before being read as numbers.
+//
+// Usage: compile-bench.bin [--runs N] [lines...]
+
+#define MAX_RUNS 101
+#define MAX_SETS 16
+#define MAX_SIZES 16
+#define MAX_LINE 128
+#define DEFAULT_LINES 10000
+// The definitions must fit in the memory addressed by HERE, past that number
+// the sources are only made of interpreted lines.
+#define MAX_DEFINITIONS 3000
+#define CONSTANT_EVERY 8
+
+struct word_set_s {
+    const char* name;
+    double times[MAX_RUNS];
+    sef_unsigned_t probes;
+};
+
+static struct word_set_s sets[MAX_SETS];
+static int set_count;
+static int run_index;
+static double last_set_end;
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+static double median(double* values, int count) {
+    qsort(values, count, sizeof(double), compare_doubles);
+    return values[count / 2];
+}
+
+// Overrides the weak function of libseforth to time each set of system words
+// from the end of the previous one.
+void sef_system_words_compiled(sef_forth_state_t* state, const char* set_name) {
+    static int set_index;
+    static sef_unsigned_t last_probes;
+    double now = now_ns();
+    if (strcmp(set_name, "C words") == 0) {
+        set_index = 0;
+        last_probes = 0;
+    }
+    if (set_index >= MAX_SETS) {
+        return;
+    }
+    struct word_set_s* set = &sets[set_index++];
+    set->name = set_name;
+    set->times[run_index] = now - last_set_end;
+    set->probes = sef_dictionary_probes(state) - last_probes;
+    last_probes = sef_dictionary_probes(state);
+    last_set_end = now;
+    if (set_index > set_count) {
+        set_count = set_index;
+    }
+}
+
+static void time_init(sef_forth_state_t* fs, int runs) {
+    double totals[MAX_RUNS];
+    for (run_index=0; run_index<runs; run_index++) {
+        double start = now_ns();
+        last_set_end = start;
+        sef_init(fs);
+        totals[run_index] = now_ns() - start;
+    }
+    printf("%-32s %12s %12s\n", "sef_init", "median ms", "probes");
+    for (int i=0; i<set_count; i++) {
+        printf("  %-30s %12.3f %12lu\n", sets[i].name, median(sets[i].times, runs) / 1e6, (unsigned long) sets[i].probes);
+    }
+    printf("  %-30s %12.3f %12lu\n\n", "total", median(totals, runs) / 1e6, (unsigned long) sef_dictionary_probes(fs));
+}
+
+struct source_s {
+    char* text;
+    size_t size;
+    long lines;
+    long definitions;
+    long tokens;
+};
+
+// Pseudo-random numbers, so that the sources are the same from one run to
+// the next.
+static unsigned long next_random(unsigned long* seed) {
+    *seed = *seed * 6364136223846793005UL + 1442695040888963407UL;
+    return *seed >> 33;
+}
+
+// Write the name of a word defined before, or of a system word if there is
+// none, and return the number of characters written.
+static int earlier_word(char* line, unsigned long* seed, long definitions, bool constant) {
+    if (definitions == 0) {
+        return sprintf(line, constant ? "bl" : "1+");
+    }
+    long word = next_random(seed) % definitions;
+    if (constant) {
+        word -= word % CONSTANT_EVERY;
+        return sprintf(line, "c%ld", word);
+    }
+    word -= word % CONSTANT_EVERY == 0;
+    return word < 0 ? sprintf(line, "1+") : sprintf(line, "w%ld", word);
+}
+
+// Generate a source of the given number of lines. The colon definitions, named
+// `wN`, take a number and return one, and every CONSTANT_EVERY definition is a
+// constant named `cN`. The other lines run those words on literals.
+static bool generate_source(long lines, struct source_s* source) {
+    source->text = malloc(lines * MAX_LINE + 1);
+    if (source->text == NULL) {
+        return false;
+    }
+    source->lines = lines;
+    source->definitions = 0;
+    source->tokens = 0;
+    long max_definitions = lines / 2 < MAX_DEFINITIONS ? lines / 2 : MAX_DEFINITIONS;
+    long definition_every = lines / (max_definitions > 0 ? max_definitions : 1);
+    unsigned long seed = 42;
+    char* line = source->text;
+    for (long i=0; i<lines; i++) {
+        long literal = (long) next_random(&seed) % 20000 - 10000;
+        long n = source->definitions;
+        if (i % definition_every == 0 && n < max_definitions) {
+            if (n % CONSTANT_EVERY == 0) {
+                line += sprintf(line, "%ld constant c%ld\n", literal, n);
+                source->tokens += 3;
+            } else {
+                line += sprintf(line, ": w%ld ( n -- n ) %ld + ", n, literal);
+                line += earlier_word(line, &seed, n, false);
+                line += sprintf(line, " ");
+                line += earlier_word(line, &seed, n, true);
+                line += sprintf(line, " xor %ld and ;\n", next_random(&seed) % 0x10000);
+                source->tokens += 15;
+            }
+            source->definitions++;
+        } else {
+            line += sprintf(line, "%ld ", literal);
+            line += earlier_word(line, &seed, n, false);
+            line += sprintf(line, " %ld - ", (long) next_random(&seed) % 1000);
+            line += earlier_word(line, &seed, n, true);
+            line += sprintf(line, " + drop\n");
+            source->tokens += 7;
+        }
+    }
+    source->size = line - source->text;
+    return true;
+}
+
+static bool time_source(sef_forth_state_t* fs, long lines, int runs) {
+    struct source_s source;
+    if (!generate_source(lines, &source)) {
+        fprintf(stderr, "Can't generate a source of %ld lines.\n", lines);
+        return false;
+    }
+    double times[MAX_RUNS];
+    sef_unsigned_t probes = 0;
+    bool ok = true;
+    for (int i=0; i<runs && ok; i++) {
+        sef_init(fs);
+        sef_unsigned_t probes_before = sef_dictionary_probes(fs);
+        double start = now_ns();
+        sef_eval_buffer(fs, source.text, source.size);
+        times[i] = now_ns() - start;
+        probes = sef_dictionary_probes(fs) - probes_before;
+        ok = sef_ready_to_run(fs);
+    }
+    free(source.text);
+    if (!ok) {
+        fprintf(stderr, "The source of %ld lines failed.\n", lines);
+        return false;
+    }
+    double seconds = median(times, runs) / 1e9;
+    printf("%10ld %12ld %10ld %10.1f %12.0f %12.0f %14.1f\n", source.lines, source.definitions,
+           source.tokens, seconds * 1e3, source.lines / seconds, source.tokens / seconds,
+           (double) probes / source.tokens);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int runs = 3;
+    int first_size = 1;
+    if (argc > 2 && strcmp(argv[1], "--runs") == 0) {
+        runs = atoi(argv[2]);
+        first_size = 3;
+    }
+    long sizes[MAX_SIZES] = {DEFAULT_LINES};
+    int size_count = argc > first_size ? argc - first_size : 1;
+    if (runs < 1 || runs > MAX_RUNS || size_count > MAX_SIZES) {
+        fprintf(stderr, "Usage: %s [--runs N] [lines...]\n", argv[0]);
+        return 1;
+    }
+    for (int i=first_size; i<argc; i++) {
+        sizes[i - first_size] = atol(argv[i]);
+        if (sizes[i - first_size] <= 0) {
+            fprintf(stderr, "Usage: %s [--runs N] [lines...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    sef_forth_state_t* fs = malloc(sizeof(sef_forth_state_t));
+    time_init(fs, runs);
+    bool failed = false;
+    printf("%10s %12s %10s %10s %12s %12s %14s\n", "lines", "definitions", "words", "median ms", "lines/s", "words/s", "probes/word");
+    for (int i=0; i<size_count; i++) {
+        failed |= !time_source(fs, sizes[i], runs);
+    }
+    free(fs);
+    return failed ? 1 : 0;
+}
+
@@ -1,4 +1,5 @@
 #include "private_api.h"
+#include "string.h"
 
 #ifndef SEF_BLOCK_SIZE
 #define SEF_BLOCK_SIZE 1024
@@ -28,15 +29,40 @@ static void number_of_block_buffers(forth_state_t* fs) {
     sef_push_data(fs, SEF_NUMBER_OF_BLOCK_BUFFERS);
 }
 
+struct block_c_func_s {
+    const char* name;
+    cfunc func;
+};
+
+static const struct block_c_func_s all_block_c_func[] = {
+    {"block-size",              block_size},
+    {"read-buffer",             read_buffer},
+    {"write-buffer",            write_buffer},
+    {"number-of-block-buffers", number_of_block_buffers},
+};
+
 void sef_register_block_cfunc(forth_state_t* fs) {
-    sef_register_cfunc(fs, "block-size",              block_size,              false);
-    sef_register_cfunc(fs, "read-buffer",             read_buffer,             false);
-    sef_register_cfunc(fs, "write-buffer",            write_buffer,            false);
-    sef_register_cfunc(fs, "number-of-block-buffers", number_of_block_buffers, false);
+    for (size_t i = 0; i < sizeof(all_block_c_func) / sizeof(struct block_c_func_s); i++) {
+        sef_register_cfunc(fs, all_block_c_func[i].name, all_block_c_func[i].func, false);
+    }
+}
+
+const char* sef_block_cfunc_at(size_t index, cfunc* func) {
+    if (index >= sizeof(all_block_c_func) / sizeof(struct block_c_func_s)) {
+        return NULL;
+    }
+    *func = all_block_c_func[index].func;
+    return all_block_c_func[index].name;
 }
 #else
 void sef_register_block_cfunc(forth_state_t* fs) {
     UNUSED(fs);
 }
+
+const char* sef_block_cfunc_at(size_t index, cfunc* func) {
+    UNUSED(index);
+    UNUSED(func);
+    return NULL;
+}
 #endif
 
@@ -3,4 +3,8 @@
 
 void sef_register_block_cfunc(forth_state_t* fs);
 
+// Return the name of the block word at the given index of its table and set
+// `func` to its function, or return NULL past the end of the table.
+const char* sef_block_cfunc_at(size_t index, cfunc* func);
+
 #endif
@@ -72,7 +72,7 @@ void sef_register_block_file(sef_forth_state_t* _fs, const char* filename, int n
     forth_state_t* fs = (forth_state_t*) _fs;
     run_cached_word(fs, ALIGN);
 
-    sef_create(fs, "", 0);
+    sef_create_entry(fs, "", 0);
     dictionary_entry_t bfd_entry = fs->last_dictionary_entry;
     sef_add_word_in_cache(fs, bfd_entry, BLOCK_FILE_DATA);
     sef_allot(fs, sizeof(block_file_data));
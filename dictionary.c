@@ -2,7 +2,13 @@
 #include "string.h"
 #include "stdio.h"
 
-#define DICTIONARY_MAGIC 0xD1C7
+// Number of cells of the header between the name and the execution token
+#define ENTRY_HEADER_CELLS 5
+// Number of cells from the execution token to the parameters
+#define ENTRY_CODE_FIELD_CELLS 3
+
+// The smallest entry has a name of a cell, which is enough for an empty name.
+static_assert(MIN_ENTRY_CELLS == 1 + ENTRY_HEADER_CELLS + ENTRY_CODE_FIELD_CELLS, "MIN_ENTRY_CELLS must match the layout of the entries.");
 
 /* --------------------------- String manipulation -------------------------- */
 
@@ -15,11 +21,9 @@ static void to_lower(char* str) {
     }
 }
 
-static bool case_insensitive_name_match(const char* name_from_dictionary, const char* outside_name, size_t outside_name_size) {
-    if (strlen(name_from_dictionary) != outside_name_size || strlen(name_from_dictionary) == 0) {
-        return false;
-    }
-    for (size_t i=0; i<strlen(name_from_dictionary); i++) {
+// The names compared have the same size, which isn't 0.
+static bool case_insensitive_name_match(const char* name_from_dictionary, const char* outside_name, size_t name_size) {
+    for (size_t i=0; i<name_size; i++) {
         char char_from_outside = outside_name[i];
         if ('A' <= char_from_outside && char_from_outside <= 'Z') {
             char_from_outside += 'a' - 'A';
@@ -31,12 +35,103 @@ static bool case_insensitive_name_match(const char* name_from_dictionary, const
     return true;
 }
 
-static bool case_sensitive_name_match(const char* name_from_dictionary, const char* outside_name, size_t outside_name_size) {
-    if (!name_from_dictionary[0]) { // Empty names should not match because they point to unfindable entries
-        return false;
+static bool case_sensitive_name_match(const char* name_from_dictionary, const char* outside_name, size_t name_size) {
+    return memcmp(name_from_dictionary, outside_name, name_size) == 0;
+}
+
+/* ------------------------------- Hash index ------------------------------- */
+
+// The entries are indexed by a hash of their name, ignoring case so that a
+// name is in the same list whether it is looked up case-sensitively or not.
+// Each list goes from the newest entry to the oldest, through a field of the
+// entry headers, and the hash is kept in the header to skip most names without
+// comparing them. The word list of the entry is mixed in the index of the list,
+// so that each word list has its own lists and searching one of them doesn't
+// go through the entries of the others.
+
+// FNV-1a hash of the lower case name.
+static sef_unsigned_t name_hash(const char* name, size_t name_len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i=0; i<name_len; i++) {
+        char c = name[i];
+        if ('A' <= c && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        hash = (hash ^ (uint8_t) c) * 16777619u;
+    }
+    return hash;
+}
+
+static sef_unsigned_t* get_entry_hash(dictionary_entry_t entry) {
+    return (sef_unsigned_t*) sef_get_previous_entry(entry) - 2;
+}
+
+static sef_int_t* get_entry_wordlist(dictionary_entry_t entry) {
+    return (sef_int_t*) sef_get_previous_entry(entry) - 3;
+}
+
+static dictionary_entry_t* get_next_in_bucket(dictionary_entry_t entry) {
+    return (dictionary_entry_t*) sef_get_previous_entry(entry) - 1;
+}
+
+static size_t bucket_index(sef_unsigned_t hash, sef_int_t wordlist) {
+    return (hash + (sef_unsigned_t) wordlist * 0x9E3779B1u) % SEF_DICTIONARY_BUCKETS;
+}
+
+static dictionary_entry_t* get_bucket(forth_state_t* fs, sef_unsigned_t hash, sef_int_t wordlist) {
+    return &fs->dictionary_buckets[bucket_index(hash, wordlist)];
+}
+
+// Entries without a name can't be found, so they are left out.
+static void index_entry(forth_state_t* fs, dictionary_entry_t entry) {
+    *get_next_in_bucket(entry) = NULL;
+    if (*sef_get_entry_name_len(entry) == 0) {
+        return;
+    }
+    dictionary_entry_t* bucket = get_bucket(fs, *get_entry_hash(entry), *get_entry_wordlist(entry));
+    *get_next_in_bucket(entry) = *bucket;
+    *bucket = entry;
+}
+
+// The indexes follow the entries registered with sef_register_new_word. If the
+// last entry was changed in another way, most likely by a marker going back to
+// an older entry, the entries after it might already be overwritten, so the
+// indexes are built again from the entries reachable from the last one. The
+// entries of a shared dictionary have indexes of their own and are left out.
+void sef_follow_dictionary_changes(forth_state_t* fs) {
+    if (fs->last_indexed_entry == fs->last_dictionary_entry) {
+        return;
+    }
+    memset(fs->dictionary_buckets, 0, sizeof(fs->dictionary_buckets));
+    fs->entry_count = 0;
+    // Indexing from the newest entry gives lists from the oldest one, that are
+    // then reversed, and so is the array of entries.
+    for (dictionary_entry_t entry = fs->last_dictionary_entry; entry != NULL; entry = *sef_get_previous_entry(entry)) {
+#if SEF_SHARED_DICTIONARY
+        if (sef_is_in_shared_dictionary(fs, entry)) {
+            break;
+        }
+#endif
+        index_entry(fs, entry);
+        fs->entries[fs->entry_count++] = entry;
+    }
+    for (sef_int_t i=0; i<fs->entry_count/2; i++) {
+        dictionary_entry_t newer = fs->entries[i];
+        fs->entries[i] = fs->entries[fs->entry_count - 1 - i];
+        fs->entries[fs->entry_count - 1 - i] = newer;
+    }
+    for (size_t i=0; i<SEF_DICTIONARY_BUCKETS; i++) {
+        dictionary_entry_t newer = NULL;
+        dictionary_entry_t entry = fs->dictionary_buckets[i];
+        while (entry != NULL) {
+            dictionary_entry_t older = *get_next_in_bucket(entry);
+            *get_next_in_bucket(entry) = newer;
+            newer = entry;
+            entry = older;
+        }
+        fs->dictionary_buckets[i] = newer;
     }
-    return (strncmp(name_from_dictionary, outside_name, outside_name_size) == 0) &&
-           (strlen(name_from_dictionary) == outside_name_size);
+    fs->last_indexed_entry = fs->last_dictionary_entry;
 }
 
 /* -------------------------------- Name size ------------------------------- */
@@ -67,22 +162,42 @@ static void warn_if_exists(forth_state_t* fs, const char* name, size_t name_len)
     }
 }
 
-#define ALLOT_AND_LEAVE_IF_ERROR(fs, size)                              \
-    if (fs->here.byte - &fs->forth_memory[0] > SEF_FORTH_MEMORY_SIZE) { \
-        return;                                                         \
-    }                                                                   \
-    sef_allot(fs, size)                                                  
+// Operation code of a newly registered word. C words with a dedicated
+// implementation in the threaded engine get a more specific one afterward.
+static sef_int_t opcode_of_tags(sef_int_t tags) {
+    switch (tags & WORD_KIND) {
+        case WTM_FORTH_WORD:
+            return OP_DOCOL;
+        case WTM_CREATE:
+            return OP_DOCREATE;
+        case WTM_DOES_EXECUTION:
+            return OP_DODOES;
+        default:
+            return OP_CFUNC;
+    }
+}
+
+#define ALLOT_AND_LEAVE_IF_ERROR(fs, size)                                    \
+    if ((size_t) (fs->here.byte - fs->forth_memory) > fs->forth_memory_size) { \
+        return;                                                               \
+    }                                                                         \
+    sef_allot(fs, size)                                                        
 
 
 void sef_register_new_word(forth_state_t* fs, const char* name, size_t name_len, sef_int_t tags) {
     warn_if_exists(fs, name, name_len);
+    sef_follow_dictionary_changes(fs);
 
-    dictionary_entry_t new_entry = fs->here.cell;
-    *(sef_get_entry_magic(new_entry)) = DICTIONARY_MAGIC;
-    ALLOT_AND_LEAVE_IF_ERROR(fs, sizeof(sef_int_t) * 5 + sef_size_needed_to_store_string(name_len));
+    // The name is written first so that the execution token, which points
+    // after it, is followed by fields at fixed offsets.
+    size_t name_size = sef_size_needed_to_store_string(name_len);
+    dictionary_entry_t new_entry = (dictionary_entry_t) (fs->here.byte + name_size) + ENTRY_HEADER_CELLS;
+    ALLOT_AND_LEAVE_IF_ERROR(fs, name_size + sizeof(sef_int_t) * (ENTRY_HEADER_CELLS + ENTRY_CODE_FIELD_CELLS));
     // Storing pointer to previous entry
     *(sef_get_previous_entry(new_entry)) = fs->last_dictionary_entry;
     fs->last_dictionary_entry = new_entry;
+    // Storing the operation code matching the kind of word
+    *(sef_get_entry_code_field(new_entry)) = opcode_of_tags(tags);
     // Storing name size
     dictionary_entry_t name_len_field = sef_get_entry_name_len(new_entry);
     *name_len_field = name_len;
@@ -97,82 +212,121 @@ void sef_register_new_word(forth_state_t* fs, const char* name, size_t name_len,
     sef_int_t* word_tags_field = sef_get_word_tag_field(new_entry);
     *word_tags_field = fs->compiling_system_words ? WTM_SYSTEM_WORD : 0;
     *word_tags_field |= tags;
+    *get_entry_hash(new_entry) = name_hash(name, name_len);
+    *get_entry_wordlist(new_entry) = fs->current_wordlist;
+    index_entry(fs, new_entry);
+    fs->entries[fs->entry_count++] = new_entry;
+    fs->last_indexed_entry = new_entry;
 }
 
 /* ----------------------------- Reading entries ---------------------------- */
 
-dictionary_entry_t sef_find_entry(forth_state_t* fs, const char* name, size_t name_len) {
-    dictionary_entry_t searching = fs->last_dictionary_entry;
+static dictionary_entry_t search_list(forth_state_t* fs, dictionary_entry_t searching, const char* name, size_t name_len, sef_unsigned_t hash, sef_int_t wordlist) {
     // If we are curently defining a word, we don't want to be able to find it,
     // as it is not ready yet and we might want to shadow an old definition.
-    if (fs->compiling) {
-        searching = *sef_get_previous_entry(searching);
-    }
-
+    dictionary_entry_t hidden = fs->compiling ? fs->last_dictionary_entry : NULL;
     while (searching != NULL) {
-        const char* entry_name = sef_get_entry_name(searching);
-        sef_int_t* word_tags_field = sef_get_word_tag_field(searching);
-        bool (*name_match)(const char*, const char*, size_t) = *word_tags_field & WTM_SYSTEM_WORD || SEF_CASE_INSENSITIVE ? case_insensitive_name_match : case_sensitive_name_match;
-        if (name_match(entry_name, name, name_len)) {
-            return searching;
+        fs->dictionary_probes++;
+        if (*get_entry_hash(searching) == hash && *get_entry_wordlist(searching) == wordlist && *sef_get_entry_name_len(searching) == (sef_int_t) name_len && searching != hidden) {
+            const char* entry_name = sef_get_entry_name(searching);
+            sef_int_t* word_tags_field = sef_get_word_tag_field(searching);
+            bool (*name_match)(const char*, const char*, size_t) = *word_tags_field & WTM_SYSTEM_WORD || SEF_CASE_INSENSITIVE ? case_insensitive_name_match : case_sensitive_name_match;
+            if (name_match(entry_name, name, name_len)) {
+                return searching;
+            }
         }
-        searching = *sef_get_previous_entry(searching);
+        searching = *get_next_in_bucket(searching);
     }
     return NULL;
 }
 
-sef_int_t* sef_get_entry_magic(dictionary_entry_t entry) {
+static dictionary_entry_t search_wordlist(forth_state_t* fs, const char* name, size_t name_len, sef_unsigned_t hash, sef_int_t wordlist) {
+    dictionary_entry_t entry = search_list(fs, *get_bucket(fs, hash, wordlist), name, name_len, hash, wordlist);
+#if SEF_SHARED_DICTIONARY
+    if (entry == NULL && fs->shared_dictionary != NULL) {
+        entry = search_list(fs, fs->shared_dictionary->buckets[bucket_index(hash, wordlist)], name, name_len, hash, wordlist);
+    }
+#endif
     return entry;
 }
 
-dictionary_entry_t* sef_get_previous_entry(dictionary_entry_t entry) {
-    return (dictionary_entry_t*) (sef_get_entry_magic(entry) + 1);
-}
-
-sef_int_t* sef_get_entry_name_len(dictionary_entry_t entry) {
-    return (sef_int_t*) sef_get_previous_entry(entry) + 1;
+dictionary_entry_t sef_find_entry(forth_state_t* fs, const char* name, size_t name_len) {
+    if (name_len == 0) {
+        return NULL; // Empty names point to unfindable entries
+    }
+    sef_follow_dictionary_changes(fs);
+    sef_unsigned_t hash = name_hash(name, name_len);
+    for (sef_int_t i=0; i<fs->search_order_size; i++) {
+        dictionary_entry_t entry = search_wordlist(fs, name, name_len, hash, fs->search_order[i]);
+        if (entry != NULL) {
+            return entry;
+        }
+    }
+    return NULL;
 }
 
-char* sef_get_entry_name(dictionary_entry_t entry) {
-    return (char*) (sef_get_entry_name_len(entry) + 1);
+dictionary_entry_t sef_search_wordlist(forth_state_t* fs, const char* name, size_t name_len, sef_int_t wordlist) {
+    if (name_len == 0) {
+        return NULL;
+    }
+    sef_follow_dictionary_changes(fs);
+    return search_wordlist(fs, name, name_len, name_hash(name, name_len), wordlist);
 }
 
-sef_int_t* sef_get_word_tag_field(dictionary_entry_t entry) {
-    size_t cells_taken_by_name = sef_size_needed_to_store_string(*sef_get_entry_name_len(entry)) / sizeof(sef_int_t);
-    sef_int_t* ret = ((sef_int_t*) sef_get_entry_name(entry)) + cells_taken_by_name;
-    return ret;
+// The header of an entry is stored before its execution token. From the name,
+// it holds the name size, the word list of the entry, the hash of the name,
+// the next entry in the list of the hash index and the previous entry.
+dictionary_entry_t* sef_get_previous_entry(dictionary_entry_t entry) {
+    return (dictionary_entry_t*) entry - 1;
 }
 
-sef_int_t* sef_get_entry_special_parameters(dictionary_entry_t entry) {
-    return sef_get_word_tag_field(entry) + 1;
+sef_int_t* sef_get_entry_name_len(dictionary_entry_t entry) {
+    return (sef_int_t*) sef_get_previous_entry(entry) - 4;
 }
 
-void* sef_get_entry_parameter(dictionary_entry_t entry) {
-    return sef_get_entry_special_parameters(entry) + 1;
+char* sef_get_entry_name(dictionary_entry_t entry) {
+    sef_int_t* name_len_field = sef_get_entry_name_len(entry);
+    return ((char*) name_len_field) - sef_size_needed_to_store_string(*name_len_field);
 }
 
-dictionary_entry_t sef_try_to_find_entry(forth_state_t* fs, void* _p) {
-    // First, align the pointer to ints
-    sef_int_t* p = (sef_int_t*) ((uintptr_t) _p - ((uintptr_t) _p % sizeof(sef_int_t)));
-
-    sef_int_t* memory_start = (sef_int_t*) &fs->forth_memory[0];
-    sef_int_t* memory_end = memory_start + (SEF_FORTH_MEMORY_SIZE / sizeof(sef_int_t));
-    while (memory_start <= p && p < memory_end) {
-        if (*p == DICTIONARY_MAGIC) {
-            return p;
+// The entries are registered at increasing addresses, so the array of entries
+// is sorted and the entry owning an address is the last one starting before it.
+static dictionary_entry_t find_owner(dictionary_entry_t* entries, sef_int_t entry_count, sef_int_t* p, void* end) {
+    if (entry_count == 0 || p < entries[0] || (void*) p >= end) {
+        return NULL;
+    }
+    sef_int_t low = 0, high = entry_count;
+    while (high - low > 1) {
+        sef_int_t middle = (low + high) / 2;
+        if (entries[middle] <= p) {
+            low = middle;
+        } else {
+            high = middle;
         }
-        p--;
     }
+    return entries[low];
+}
 
-    return NULL;
+dictionary_entry_t sef_try_to_find_entry(forth_state_t* fs, void* p) {
+    sef_follow_dictionary_changes(fs);
+#if SEF_SHARED_DICTIONARY
+    const sef_shared_dictionary_t* shared = fs->shared_dictionary;
+    if (sef_is_in_shared_dictionary(fs, p)) {
+        return find_owner(shared->entries, shared->entry_count, p, shared->memory_end);
+    }
+#endif
+    return find_owner(fs->entries, fs->entry_count, p, fs->here.cell);
 }
 
 
 void sef_display_dictionary(forth_state_t* fs) {
+    if (fs->search_order_size == 0) {
+        return;
+    }
     dictionary_entry_t entry = fs->last_dictionary_entry;
     while (entry != NULL) {
         const char* name = sef_get_entry_name(entry);
-        if (name[0]) {
+        if (name[0] && *get_entry_wordlist(entry) == fs->search_order[0]) {
             for (size_t i=0; i<strlen(name); i++) {
                 sef_output(name[i]);
             }
@@ -11,23 +11,48 @@ void sef_register_new_word(forth_state_t* fs, const char* name, size_t name_size
 
 /* ----------------------------- Reading entries ---------------------------- */
 
-// Return a pointer to an entry. Return NULL and error out if it is not found.
+// Return a pointer to an entry, searched in the word lists of the search
+// order. Return NULL if it is not found.
 dictionary_entry_t sef_find_entry(forth_state_t* fs, const char* name, size_t name_size);
 
+// Return a pointer to an entry of the given word list, or NULL if it is not in
+// it.
+dictionary_entry_t sef_search_wordlist(forth_state_t* fs, const char* name, size_t name_size, sef_int_t wordlist);
+
 // Get the various constituent of an entry.
-sef_int_t* sef_get_entry_magic(dictionary_entry_t entry);
 dictionary_entry_t* sef_get_previous_entry(dictionary_entry_t entry);
 char* sef_get_entry_name(dictionary_entry_t entry);
 sef_int_t* sef_get_entry_name_len(dictionary_entry_t entry);
-sef_int_t* sef_get_word_tag_field(dictionary_entry_t entry);
-sef_int_t* sef_get_entry_special_parameters(dictionary_entry_t entry);
-void* sef_get_entry_parameter(dictionary_entry_t entry);
 
-// From a pointer, if it is in the dictionary, try to return the entry it is
-// from. Otherwise, return NULL.
+// An execution token points to the code field of its entry. The fields needed
+// to run a word are at fixed offsets after it so they are kept inline.
+static inline sef_int_t* sef_get_entry_code_field(dictionary_entry_t entry) {
+    return entry;
+}
+
+static inline sef_int_t* sef_get_word_tag_field(dictionary_entry_t entry) {
+    return entry + 1;
+}
+
+static inline sef_int_t* sef_get_entry_special_parameters(dictionary_entry_t entry) {
+    return entry + 2;
+}
+
+static inline void* sef_get_entry_parameter(dictionary_entry_t entry) {
+    return entry + 3;
+}
+
+// From a pointer, if it is in the dictionary, return the entry it is from, that
+// is the last entry whose execution token is at or before it. Otherwise, return
+// NULL. This is a binary search in an array of the entries.
 dictionary_entry_t sef_try_to_find_entry(forth_state_t* fs, void* p);
 
-// Prints all words from the dictionary
+// Build the indexes of the dictionary again if the last entry wasn't
+// registered by sef_register_new_word. The entries are then in `fs->entries`,
+// sorted by address.
+void sef_follow_dictionary_changes(forth_state_t* fs);
+
+// Prints all words from the first word list of the search order
 void sef_display_dictionary(forth_state_t* fs);
 
 #endif
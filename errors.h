@@ -7,9 +7,15 @@
 
 static_assert(sizeof(sef_int_t) == sizeof(sef_unsigned_t), "Unsigned and signed values should have the same size.");
 
-static_assert(sizeof(sef_int_t) * SEF_STATE_SIZE_INT >= sizeof(forth_state_t), "Exported state size should be at least as large as true state size");
+static_assert(sizeof(sef_int_t) * SEF_STATE_SIZE_INT >= DEFAULT_STATE_SIZE, "Exported state size should be at least as large as true state size");
 
 static_assert(!(SEF_BLOCK_FILE && !SEF_BLOCK), "Block file are only relevant if blocks are defined.");
 
+static_assert(!SEF_STACK_GUARD_PAGES || (SEF_MAPPED_STATES && SEF_CATCH_SEGFAULTS), "Guard pages need mapped states and the segfault handler.");
+
+#if SEF_DIRECT_THREADING && !defined(__GNUC__)
+#error "The threaded engine needs labels as values. Set SEF_DIRECT_THREADING to 0 with this compiler."
+#endif
+
 #endif
 
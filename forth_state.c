@@ -1,8 +1,182 @@
 #include "forth_state.h"
 #include "string.h"
 
+#if SEF_MAPPED_STATES
+#include "sys/mman.h"
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+#if SEF_STACK_GUARD_PAGES
+#include "unistd.h"
+#endif
+
+/* --------------------------------- Regions -------------------------------- */
+
+static size_t option_or_default(size_t option, size_t default_size) {
+    return option != 0 ? option : default_size;
+}
+
+// Copy of the options, which can be NULL, with the sizes set to 0 replaced by
+// the ones of the configuration.
+static sef_options_t with_defaults(const sef_options_t* options) {
+    sef_options_t ret = {0};
+    if (options != NULL) {
+        ret = *options;
+    }
+    ret.memory_size = option_or_default(ret.memory_size, SEF_FORTH_MEMORY_SIZE);
+    ret.data_stack_size = option_or_default(ret.data_stack_size, SEF_DATA_STACK_SIZE);
+    ret.return_stack_size = option_or_default(ret.return_stack_size, SEF_RETURN_STACK_SIZE);
+    ret.control_flow_stack_size = option_or_default(ret.control_flow_stack_size, SEF_CONTROL_FLOW_STACK_SIZE);
+    return ret;
+}
+
+size_t sef_state_size(const sef_options_t* options) {
+    sef_options_t sizes = with_defaults(options);
+    return STATE_SIZE(sizes.memory_size, sizes.data_stack_size, sizes.return_stack_size, sizes.control_flow_stack_size);
+}
+
+void sef_state_set_regions(forth_state_t* fs, const sef_options_t* options) {
+    sef_options_t sizes = with_defaults(options);
+    fs->size = sef_state_size(&sizes);
+    fs->mapped_size = 0;
+    fs->forth_memory_size = sizes.memory_size;
+    fs->data_stack_size = sizes.data_stack_size;
+    fs->return_stack_size = sizes.return_stack_size;
+    fs->control_flow_stack_size = sizes.control_flow_stack_size;
+    size_t memory_cells = (fs->forth_memory_size + sizeof(sef_int_t) - 1) / sizeof(sef_int_t);
+    fs->forth_memory = (uint8_t*) fs + STATE_HEADER_SIZE;
+    fs->data_stack = (sef_int_t*) fs->forth_memory + memory_cells + 1;
+    fs->return_stack = fs->data_stack + fs->data_stack_size;
+    fs->control_flow_stack = fs->return_stack + fs->return_stack_size;
+    fs->entries = (dictionary_entry_t*) (fs->control_flow_stack + fs->control_flow_stack_size);
+}
+
+#if SEF_STACK_GUARD_PAGES
+#define GUARDED_STACKS 3
+
+// Offsets from the start of a mapped state of the data, return and control
+// flow stacks and of the array of the entries, each stack being in its own
+// pages between two guard pages. The stacks are made as big as their pages
+// allow. The data stack keeps the cell of the threaded engine under it, which
+// is why the underflows of the data stack are still checked.
+struct guarded_layout_s {
+    size_t stack_offsets[GUARDED_STACKS];
+    size_t stack_cells[GUARDED_STACKS];
+    size_t entries_offset;
+    size_t size;
+};
+
+static size_t round_to_page(size_t size, size_t page) {
+    return (size + page - 1) / page * page;
+}
+
+static struct guarded_layout_s guarded_layout(const sef_options_t* options, size_t page) {
+    struct guarded_layout_s layout;
+    sef_options_t sizes = with_defaults(options);
+    size_t cells[GUARDED_STACKS] = {sizes.data_stack_size + 1, sizes.return_stack_size, sizes.control_flow_stack_size};
+    size_t offset = round_to_page(STATE_HEADER_SIZE + sizes.memory_size, page);
+    for (size_t i=0; i<GUARDED_STACKS; i++) {
+        size_t stack_size = round_to_page(cells[i] * sizeof(sef_int_t), page);
+        layout.stack_offsets[i] = offset + page;
+        layout.stack_cells[i] = stack_size / sizeof(sef_int_t);
+        offset += page + stack_size + page;
+    }
+    layout.entries_offset = offset;
+    layout.size = offset + MAX_DICTIONARY_ENTRIES(sizes.memory_size) * sizeof(dictionary_entry_t);
+    return layout;
+}
+
+// Move the stacks of a state placed by sef_state_set_regions to the layout and
+// protect their guard pages. Return false if they couldn't be protected.
+static bool guard_stacks(forth_state_t* fs, const struct guarded_layout_s* layout, size_t page) {
+    uint8_t* base = (uint8_t*) fs;
+    sef_int_t** stacks[GUARDED_STACKS] = {&fs->data_stack, &fs->return_stack, &fs->control_flow_stack};
+    sef_int_t* stack_sizes[GUARDED_STACKS] = {&fs->data_stack_size, &fs->return_stack_size, &fs->control_flow_stack_size};
+    for (size_t i=0; i<GUARDED_STACKS; i++) {
+        uint8_t* stack = base + layout->stack_offsets[i];
+        size_t stack_size = layout->stack_cells[i] * sizeof(sef_int_t);
+        if (mprotect(stack - page, page, PROT_NONE) != 0 || mprotect(stack + stack_size, page, PROT_NONE) != 0) {
+            return false;
+        }
+        *stacks[i] = (sef_int_t*) stack;
+        *stack_sizes[i] = layout->stack_cells[i];
+    }
+    fs->data_stack++;
+    fs->data_stack_size--;
+    fs->entries = (dictionary_entry_t*) (base + layout->entries_offset);
+    fs->size = layout->size;
+    return true;
+}
+#endif
+
+#if SEF_MAPPED_STATES
+// The state is mapped without reserving swap for it, so that only the pages
+// written, which are the first ones of each region for most states, take
+// memory.
+forth_state_t* sef_state_create(const sef_options_t* options) {
+#if SEF_STACK_GUARD_PAGES
+    size_t page = sysconf(_SC_PAGESIZE);
+    struct guarded_layout_s layout = guarded_layout(options, page);
+    size_t size = layout.size;
+#else
+    size_t size = sef_state_size(options);
+#endif
+    void* mapping = MAP_FAILED;
+    size_t mapped_size = size;
+    // Huge pages can't be protected one small page at a time, so the guard
+    // pages rely on transparent huge pages instead.
+#if defined(MAP_HUGETLB) && !SEF_STACK_GUARD_PAGES
+    if (options != NULL && options->huge_pages) {
+        mapped_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        // Huge pages are reserved when mapped, the mapping fails if there
+        // are not enough of them instead of failing when they are written.
+        mapping = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (mapping == MAP_FAILED) {
+        mapped_size = size;
+        mapping = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    // Without pages reserved for MAP_HUGETLB, transparent huge pages are used.
+    if (options != NULL && options->huge_pages && mapped_size == size) {
+        madvise(mapping, mapped_size, MADV_HUGEPAGE);
+    }
+#endif
+    forth_state_t* fs = mapping;
+    sef_state_set_regions(fs, options);
+    fs->mapped_size = mapped_size;
+#if SEF_STACK_GUARD_PAGES
+    if (!guard_stacks(fs, &layout, page)) {
+        munmap(mapping, mapped_size);
+        return NULL;
+    }
+#endif
+#if SEF_SHARED_DICTIONARY
+    if (options != NULL && options->shared_dictionary != NULL) {
+        sef_shared_state_init(fs, options->shared_dictionary);
+        return fs;
+    }
+#endif
+    sef_state_init(fs);
+    return fs;
+}
+
+void sef_state_destroy(forth_state_t* fs) {
+    munmap(fs, fs->mapped_size);
+}
+#endif
+
 /* -------------------------- State initialization -------------------------- */
 
+#if SEF_CATCH_SEGFAULTS
+static void install_segfault_handler(void);
+#endif
+
 static bool no_input_source(forth_state_t* fs, void* _) {
     (void) fs;
     (void) _;
@@ -14,51 +188,23 @@ static void reset_parser(forth_state_t* fs) {
     fs->input_buffer_size = 0;
     fs->parse_area_offset = 0;
     fs->input_source = NULL;
+    fs->input_source_end = NULL;
     fs->source_id = 0;
 }
 
-#define PARSE_STRING(fs, str) sef_eval_string((sef_forth_state_t*) (fs), (str))
-
-static void compile_system_forth_words(forth_state_t* fs) {
-    (void) fs;
-    extern const char* core_forth_words;
-    PARSE_STRING(fs, core_forth_words);
-    // The pre-processor would corrupt comments definitions
-    PARSE_STRING(fs, ": ( [char] ) parse 2drop ; immediate");
-    PARSE_STRING(fs, ": \\ 10 parse 2drop ; immediate");
-#if SEF_FILE_ACCESS || SEF_BLOCK
-    extern const char* linked_list;
-    PARSE_STRING(fs, linked_list);
-#endif
-#if SEF_PROGRAMMING_TOOLS
-    extern const char* tools_forth_words;
-    PARSE_STRING(fs, tools_forth_words);
-#endif
-    extern const char* shell;
-    PARSE_STRING(fs, shell);
-#if SEF_ARG_AND_EXIT_CODE
-    sef_push_data(fs, (sef_int_t) &fs->exit_code); // Push the address of the exit code to map it to the word EXIT-CODE.
-    extern const char* arg_and_exit_code_forth_words;
-    PARSE_STRING(fs, arg_and_exit_code_forth_words);
-#endif
-#if SEF_STRING
-    extern const char* string_forth_words;
-    PARSE_STRING(fs, string_forth_words);
-#endif
-#if SEF_BLOCK
-    extern const char* block_forth_words;
-    PARSE_STRING(fs, block_forth_words);
-    PARSE_STRING(fs, ": \\ blk @ 0= if ['] \\ execute else >in @ block-line-len mod >in @ swap - block-line-len + >in ! then ; immediate");
-#endif
-#if SEF_PROGRAMMING_TOOLS && SEF_ARG_AND_EXIT_CODE
-    PARSE_STRING(fs, ": (bye) exit-code ! bye ;");
-#endif
-}
-
-// Init the interpreter
-void sef_state_init(forth_state_t* fs) {
+// Put the interpreter back as it is before any word is registered
+void sef_state_clear(forth_state_t* fs) {
     fs->here.byte = &fs->forth_memory[0];
     fs->last_dictionary_entry = NULL;
+    fs->dictionary_probes = 0;
+    memset(fs->dictionary_buckets, 0, sizeof(fs->dictionary_buckets));
+    fs->last_indexed_entry = NULL;
+    fs->entry_count = 0;
+    fs->shared_dictionary = NULL;
+    fs->search_order[0] = FORTH_WORDLIST;
+    fs->search_order_size = 1;
+    fs->current_wordlist = FORTH_WORDLIST;
+    fs->wordlist_count = FORTH_WORDLIST;
     fs->data_stack_index = 0;
     fs->return_stack_index = 0;
     fs->control_flow_stack_index = 0;
@@ -69,24 +215,44 @@ void sef_state_init(forth_state_t* fs) {
     fs->quit = false;
     fs->exit_code = 0;
     memset(fs->word_cache, 0, sizeof(fs->word_cache));
+    memset(fs->last_instructions, 0, sizeof(fs->last_instructions));
+    fs->last_instructions_end = NULL;
+    fs->instructions_end = NULL;
+    fs->optimized_cells = 0;
     reset_parser(fs);
     fs->compiling_system_words = true;
-    sef_register_default_cfunc(fs);
-    sef_fill_c_func_in_cache(fs);
-    sef_register_parser_cfunc(fs);
-    sef_register_block_cfunc(fs);
-    compile_system_forth_words(fs);
-    sef_fill_forth_words_in_cache(fs);
-    fs->compiling_system_words = false;
+#if SEF_CATCH_SEGFAULTS
+    install_segfault_handler();
+#endif
+}
+
+// Init the interpreter
+void sef_state_init(forth_state_t* fs) {
+#if SEF_PRECOMPILED_DICTIONARY
+    extern const sef_unsigned_t sef_system_image[];
+    extern const size_t sef_system_image_size;
+    if (!sef_image_decode(fs, (const uint8_t*) sef_system_image, sef_system_image_size)) {
+        error_msg("The precompiled dictionary doesn't match this build of SEForth.\n");
+    }
+#else
+    sef_compile_system_words(fs);
+#endif
 }
 
 /* --------------------------- Stack manipulation --------------------------- */
 
-#if SEF_STACK_BOUND_CHECKS
-#define STACK_BOUND_CHECK(fs, stack_name, stack_size)                                         \
-    if (fs->stack_name ## _stack_index < 0 || fs->stack_name ## _stack_index >= stack_size) { \
-        SEF_ERROR_OUT(fs, "Stack '%s' out of bound. Resetting state.\n", #stack_name);        \
-    }                                                                                          
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+#define UNDERFLOW_CHECKED_data SEF_DATA_UNDERFLOW_CHECKS
+#define UNDERFLOW_CHECKED_return 0
+#define UNDERFLOW_CHECKED_control_flow 0
+// The stacks between guard pages are only checked for the underflows that
+// can't fault.
+#define STACK_BOUND_CHECK(fs, stack_name, stack_size)                                                 \
+    if (SEF_HAS_GUARD_PAGES(fs)                                                                       \
+        ? UNDERFLOW_CHECKED_ ## stack_name && fs->stack_name ## _stack_index < 0                      \
+        : SEF_STACK_INDEX_CHECKS && (fs->stack_name ## _stack_index < 0 || fs->stack_name ## _stack_index >= stack_size)) { \
+        SEF_ERROR_OUT(fs, "Stack '%s' out of bound. Resetting state.\n", #stack_name);                \
+    }
 #else
 #define STACK_BOUND_CHECK(fs, stack_name, stack_size)
 #endif
@@ -109,9 +275,9 @@ sef_int_t sef_pop_ ## stack_name(forth_state_t* fs) {
     return ret;                                                                 \
 }                                                                                
 
-STACK_OPERATIONS(data, SEF_DATA_STACK_SIZE)
-STACK_OPERATIONS(return, SEF_RETURN_STACK_SIZE)
-STACK_OPERATIONS(control_flow, SEF_CONTROL_FLOW_STACK_SIZE)
+STACK_OPERATIONS(data, fs->data_stack_size)
+STACK_OPERATIONS(return, fs->return_stack_size)
+STACK_OPERATIONS(control_flow, fs->control_flow_stack_size)
 
 /* ---------------------------- Taking down state --------------------------- */
 
@@ -121,6 +287,11 @@ void sef_quit(forth_state_t* fs) {
     fs->quit = true;
     fs->code_pointer = NULL;
     fs->return_stack_index = 0;
+#if SEF_PROFILE
+    if (sef_profiling) {
+        sef_profile_unwind();
+    }
+#endif
     fs->compiling = false;
     reset_parser(fs);
 }
@@ -182,35 +353,12 @@ void sef_reset(forth_state_t* fs) {
 
 /* ----------------------------- Word execution ----------------------------- */
 
-// Executes the code pointer. Return true if it was executed and false if it
-// wasn't because it is NULL.
-static bool sef_execute_code_pointer(forth_state_t* fs) {
-    if (fs->code_pointer == NULL) {
-        return false;
-    }
-
-    sef_int_t entry = *fs->code_pointer;
-    sef_call_entry(fs, (dictionary_entry_t) entry);
-    if (fs->code_pointer != NULL) { // If we aborted, we don't want to increament the code pointer
-        fs->code_pointer += 1;
-    }
-    return true;
-}
-
-void sef_run(forth_state_t* fs) {
-    while (sef_execute_code_pointer(fs));
-}
-
 void sef_exit(forth_state_t* fs) {
     fs->code_pointer = (sef_int_t*) sef_pop_return(fs);
+    PROFILE_RETURN(fs->return_stack_index);
 }
 
-#if SEF_CATCH_SEGFAULTS
-static void _sef_call_entry(forth_state_t* fs, dictionary_entry_t entry)
-#else
-void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry)
-#endif
-{
+static void _sef_call_entry(forth_state_t* fs, dictionary_entry_t entry) {
     debug_msg("Calling % *s% *s%s\n", fs->return_stack_index, "", fs->return_stack_index, "", sef_get_entry_name(entry));
     sef_int_t word_tags = *(sef_get_word_tag_field(entry));
     void* parameters = sef_get_entry_parameter(entry);
@@ -219,7 +367,8 @@ void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry)
         case WTM_DOES_EXECUTION:
             sef_int_t* new_code_pointer = sef_get_entry_special_parameters(entry);
             sef_push_return(fs, (sef_int_t) fs->code_pointer);
-            sef_push_data(fs, (sef_int_t) (parameters));
+            sef_push_data(fs, (sef_int_t) sef_get_entry_body(fs, entry));
+            PROFILE_CALL(entry, fs->return_stack_index);
             if (fs->code_pointer != NULL) {
                 fs->code_pointer = (dictionary_entry_t) *new_code_pointer; // Currently pointing to `DOES>`, but will be shifted to what we cant to execute by the run word function.
             } else {
@@ -227,13 +376,29 @@ void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry)
             }
             break;
         case WTM_CREATE:
-            sef_exec_create(fs, parameters);
+            sef_exec_create(fs, sef_get_entry_body(fs, entry));
             break;
         case WTM_C_WORD:
+#if SEF_PROFILE
+            // The words with an opcode are primitives of the threaded engine
+            if (*sef_get_entry_code_field(entry) == OP_CFUNC) {
+                PROFILE_C_WORD(fs, entry, sef_exec_cfunc(fs, parameters));
+                break;
+            }
+#endif
             sef_exec_cfunc(fs, parameters);
             break;
         case WTM_FORTH_WORD:
+#if SEF_JIT_ENABLED
+            // When a word is running, the word called only starts once we
+            // return to the engine, which runs its threaded code.
+            if (*sef_get_entry_code_field(entry) == OP_DONATIVE && fs->code_pointer == NULL) {
+                PROFILE_C_WORD(fs, entry, sef_jit_exec(fs, entry));
+                break;
+            }
+#endif
             sef_exec_forth_word(fs, parameters);
+            PROFILE_CALL(entry, fs->return_stack_index);
             break;
         default:
             SEF_ERROR_OUT(fs, "Invalid word kind %X.", (int) word_tags & WORD_KIND);
@@ -244,46 +409,171 @@ void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry)
 #include <setjmp.h>
 #include <signal.h>
 
-static sigjmp_buf point;
-static void segfault_handler(int sig, siginfo_t *dont_care, void *dont_care_either) {
-    UNUSED(sig);
-    UNUSED(dont_care);
-    UNUSED(dont_care_either);
-    longjmp(point, 1);
+// Recovery point of the outermost call to sef_call_with_segfault_recovery. It
+// is NULL when no Forth code is running on this thread.
+static _Thread_local sigjmp_buf* recovery_point = NULL;
+// Last entry called with sef_call_entry, blamed for segfaults happening while
+// no definition is being run.
+static _Thread_local dictionary_entry_t called_entry = NULL;
+#if SEF_STACK_GUARD_PAGES
+// Address whose access caused the last segfault, to tell a stack overflowing
+// in a guard page from other faults.
+static _Thread_local const uint8_t* fault_address = NULL;
+#endif
+// Handler installed before ours, which gets the faults not caused by Forth code.
+static struct sigaction previous_handler;
+
+static void segfault_handler(int sig, siginfo_t *info, void *context) {
+    if (recovery_point == NULL) {
+        if (previous_handler.sa_flags & SA_SIGINFO) {
+            previous_handler.sa_sigaction(sig, info, context);
+        } else if (previous_handler.sa_handler != SIG_DFL && previous_handler.sa_handler != SIG_IGN) {
+            previous_handler.sa_handler(sig);
+        } else {
+            // Let the faulting instruction run again without us, which crashes
+            // as usual.
+            sigaction(sig, &previous_handler, NULL);
+        }
+        return;
+    }
+#if SEF_STACK_GUARD_PAGES
+    fault_address = info->si_addr;
+#else
+    UNUSED(info);
+#endif
+    siglongjmp(*recovery_point, 1);
 }
 
-void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry) {
-    // Prepare catching of segfaults
+#if SEF_STACK_GUARD_PAGES
+// Name of the stack of the state whose guard pages hold `address`, or NULL.
+// The index of that stack is brought back in its bounds, as it might have been
+// moved before the fault.
+static const char* guarded_stack_at(forth_state_t* fs, const uint8_t* address) {
+    if (fs->mapped_size == 0) {
+        return NULL;
+    }
+    size_t page = sysconf(_SC_PAGESIZE);
+    const char* names[GUARDED_STACKS] = {"data", "return", "control_flow"};
+    uint8_t* starts[GUARDED_STACKS] = {(uint8_t*) (fs->data_stack - 1), (uint8_t*) fs->return_stack, (uint8_t*) fs->control_flow_stack};
+    uint8_t* ends[GUARDED_STACKS] = {(uint8_t*) (fs->data_stack + fs->data_stack_size), (uint8_t*) (fs->return_stack + fs->return_stack_size), (uint8_t*) (fs->control_flow_stack + fs->control_flow_stack_size)};
+    sef_int_t* indexes[GUARDED_STACKS] = {&fs->data_stack_index, &fs->return_stack_index, &fs->control_flow_stack_index};
+    for (size_t i=0; i<GUARDED_STACKS; i++) {
+        bool underflow = address >= starts[i] - page && address < starts[i];
+        bool overflow = address >= ends[i] && address < ends[i] + page;
+        if (underflow || overflow) {
+            *indexes[i] = 0;
+            return names[i];
+        }
+    }
+    return NULL;
+}
+#endif
+
+// The handler is installed once for the whole process and only jumps back if
+// a recovery point is armed on the faulting thread. Other faults are given to
+// the handler it replaced.
+static void install_segfault_handler(void) {
+    static bool installed = false;
+    if (installed) {
+        return;
+    }
     struct sigaction sa;
-    memset(&sa, 0, sizeof(sigaction));
+    memset(&sa, 0, sizeof(sa));
     sigemptyset(&sa.sa_mask);
-    sa.sa_flags     = SA_NODEFER;
+    sa.sa_flags     = SA_SIGINFO | SA_NODEFER;
     sa.sa_sigaction = segfault_handler;
-    sigaction(SIGSEGV, &sa, NULL);
+    sigaction(SIGSEGV, &sa, &previous_handler);
+    installed = true;
+}
 
-// Execute the risky code
-    if (setjmp(point) == 0) {
-        _sef_call_entry(fs, entry);
+void sef_call_with_segfault_recovery(forth_state_t* fs, void (*func)(forth_state_t*, const void*), const void* arg) {
+    if (recovery_point != NULL) { // Already protected by a caller
+        func(fs, arg);
+        return;
+    }
+
+    sigjmp_buf point;
+    if (sigsetjmp(point, 0) == 0) {
+        recovery_point = &point;
+        func(fs, arg);
+        recovery_point = NULL;
     } else {
-        const char* entry_name = sef_get_entry_name(entry);
+        recovery_point = NULL;
+#if SEF_STACK_GUARD_PAGES
+        const char* stack = guarded_stack_at(fs, fault_address);
+        if (stack != NULL) {
+            SEF_ERROR_OUT(fs, "Stack '%s' out of bound. Resetting state.\n", stack);
+            return;
+        }
+#endif
+        dictionary_entry_t culprit = called_entry;
+#if SEF_DIRECT_THREADING
+        // The threaded engine doesn't call sef_call_entry for each word
+        if (fs->code_pointer != NULL) {
+            culprit = (dictionary_entry_t) *fs->code_pointer;
+        }
+#endif
+        const char* entry_name = culprit != NULL ? sef_get_entry_name(culprit) : "???";
         SEF_ERROR_OUT(fs, "SEGFAULT while executing word %s.\n", entry_name);
     }
+}
+
+void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry) {
+    called_entry = entry;
+    _sef_call_entry(fs, entry);
+}
+#else
+void sef_call_with_segfault_recovery(forth_state_t* fs, void (*func)(forth_state_t*, const void*), const void* arg) {
+    func(fs, arg);
+}
+
+void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry) {
+    _sef_call_entry(fs, entry);
+}
+#endif
+
+#if SEF_DIRECT_THREADING
+static void run(forth_state_t* fs, const void* arg) {
+    UNUSED(arg);
+    sef_threaded_run(fs);
+}
+#else
+// Executes the code pointer. Return true if it was executed and false if it
+// wasn't because it is NULL.
+static bool sef_execute_code_pointer(forth_state_t* fs) {
+    if (fs->code_pointer == NULL) {
+        return false;
+    }
 
-    // Stop the fault catcher
-    sa.sa_sigaction = NULL;
-    sa.sa_handler = SIG_IGN;
-    sigaction(SIGSEGV, &sa, NULL);
+    sef_int_t entry = *fs->code_pointer;
+#if SEF_PROFILE_PAIRS
+    sef_profile_dispatch((dictionary_entry_t) entry);
+#endif
+    sef_call_entry(fs, (dictionary_entry_t) entry);
+    if (fs->code_pointer != NULL) { // If we aborted, we don't want to increament the code pointer
+        fs->code_pointer += 1;
+    }
+    return true;
+}
+
+static void run(forth_state_t* fs, const void* arg) {
+    UNUSED(arg);
+    while (sef_execute_code_pointer(fs));
 }
 #endif
 
+void sef_run(forth_state_t* fs) {
+    sef_call_with_segfault_recovery(fs, run, NULL);
+}
+
 /* ------------------------- Forth memory management ------------------------ */
 
 // Request some bytes from the forth memory
 void sef_allot(forth_state_t* fs, size_t byte_requested) {
     fs->here.byte += byte_requested;
 #if SEF_STACK_BOUND_CHECKS
-    if (fs->here.byte - &fs->forth_memory[0] > SEF_FORTH_MEMORY_SIZE) {
-        SEF_ERROR_OUT(fs, "Forth memory overflowed by %i bytes.\n", (fs->here.byte - fs->forth_memory) - SEF_FORTH_MEMORY_SIZE);
+    if ((size_t) (fs->here.byte - fs->forth_memory) > fs->forth_memory_size) {
+        SEF_ERROR_OUT(fs, "Forth memory overflowed by %i bytes.\n", (int) ((fs->here.byte - fs->forth_memory) - fs->forth_memory_size));
     }
 #endif
 }
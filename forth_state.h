@@ -9,46 +9,137 @@
 #define FORTH_BOOL(x) ((x) ? FORTH_TRUE : 0)
 #define FORTH_FALSE FORTH_BOOL(false)
 
+// Cells taken by the smallest dictionary entry, which bounds the number of
+// entries that can start in the memory addressed by HERE.
+#define MIN_ENTRY_CELLS 9
+#define MAX_DICTIONARY_ENTRIES(memory_size) ((memory_size) / (MIN_ENTRY_CELLS * sizeof(sef_int_t)) + 1)
+
+// Maximum number of word lists in the search order, and the word list holding
+// the system words, which is the only one searched at startup.
+#define SEARCH_ORDER_MAX 16
+#define FORTH_WORDLIST 1
+
+// The stacks are compared to their size unless overflowing them faults in a
+// guard page, which only the states made by sef_state_create have. Even then,
+// the data stack is checked for underflows, as the cell under it is where the
+// threaded engine spills the top of an empty data stack, so reading it past the
+// bottom of the stack can't fault.
+#define SEF_STACK_INDEX_CHECKS SEF_STACK_BOUND_CHECKS
+#define SEF_DATA_UNDERFLOW_CHECKS SEF_STACK_GUARD_PAGES
+#if SEF_STACK_GUARD_PAGES
+#define SEF_HAS_GUARD_PAGES(fs) ((fs)->mapped_size != 0)
+#else
+#define SEF_HAS_GUARD_PAGES(fs) false
+#endif
+
 struct forth_state_s;
 typedef bool (*input_source_refill_t)(struct forth_state_s* state, void* input_source);
 
+// The registers used by the engines are at the start of the state, in the
+// first cache line. The regions sized at runtime follow the state, from
+// STATE_HEADER_SIZE, which keeps them aligned on a cache line if the state is.
 struct forth_state_s {
-    // Memory spaces
-    uint8_t forth_memory[SEF_FORTH_MEMORY_SIZE];
-    uint8_t pad[SEF_PAD_SIZE];
-    sef_int_t data_stack[SEF_DATA_STACK_SIZE];
-    sef_int_t return_stack[SEF_RETURN_STACK_SIZE];
-    sef_int_t control_flow_stack[SEF_CONTROL_FLOW_STACK_SIZE];
-    // Memory pointer and indexes
+    // Registers of the engines
+    sef_int_t* code_pointer;
+    sef_int_t data_stack_index;
+    sef_int_t return_stack_index;
+    sef_int_t* data_stack;
+    sef_int_t* return_stack;
     union {
         uint8_t* byte;
         sef_int_t* cell;
     } here;
-    dictionary_entry_t last_dictionary_entry;
-    sef_int_t data_stack_index;
-    sef_int_t return_stack_index;
+    sef_int_t compiling;
+    bool bye;
+    bool quit;
+    // Regions following the state
+    uint8_t* forth_memory;
+    size_t forth_memory_size;
+    sef_int_t data_stack_size;
+    sef_int_t return_stack_size;
+    sef_int_t* control_flow_stack;
+    sef_int_t control_flow_stack_size;
     sef_int_t control_flow_stack_index;
+    dictionary_entry_t* entries; // Sorted by address.
+    size_t size; // Bytes from the start of the state to the end of its regions.
+    size_t mapped_size; // Set if the state was mapped by sef_state_create.
+    uint8_t pad[SEF_PAD_SIZE];
+    // Dictionary
+    dictionary_entry_t last_dictionary_entry;
+    sef_unsigned_t dictionary_probes; // Entries compared to a name by sef_find_entry.
+    dictionary_entry_t dictionary_buckets[SEF_DICTIONARY_BUCKETS];
+    dictionary_entry_t last_indexed_entry;
+    sef_int_t entry_count;
+    const struct sef_shared_dictionary_s* shared_dictionary; // Searched after the entries of the state.
+    // Search order
+    sef_int_t search_order[SEARCH_ORDER_MAX]; // The first word list is searched first.
+    sef_int_t search_order_size;
+    sef_int_t current_wordlist;
+    sef_int_t wordlist_count;
     // Internal variables
-    sef_int_t compiling;
     sef_int_t base;
-    sef_int_t* code_pointer;
     sef_int_t exit_code;
-    bool bye;
-    bool quit;
     // Word cache
     dictionary_entry_t word_cache[WORD_IN_CACHE_COUNT];
+    // Superinstructions
+    sef_int_t* last_instructions[SUPERINSTRUCTION_MAX_LENGTH];
+    sef_int_t* last_instructions_end;
+    // Tail calls
+    sef_int_t* tail_call_candidate;
+    sef_int_t* branches_after_tail_call_candidate;
+    sef_int_t* recursive_tail_calls;
+    sef_int_t return_stack_balance;
+    // Optimizer
+    sef_int_t* instructions_end;
+    sef_int_t optimized_cells;
     // Parser
     sef_int_t input_buffer_size;
     char* input_buffer;
     sef_int_t parse_area_offset;
     void* input_source;
+    const char* input_source_end; // End of the text of the C buffer input source.
     input_source_refill_t input_source_refill;
     sef_int_t source_id;
     bool compiling_system_words;
 };
 
+#define CACHE_LINE_SIZE 64
+#define STATE_HEADER_SIZE ((sizeof(forth_state_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE)
+
+// Bytes taken by a state and its regions. The memory addressed by HERE is
+// first, then the data stack, after a guard cell where the threaded engine
+// spills the top of an empty data stack, the return stack, the control flow
+// stack and the array of the entries.
+#define STATE_SIZE(memory_size, data_stack_size, return_stack_size, control_flow_stack_size) \
+    (STATE_HEADER_SIZE + ((memory_size) + sizeof(sef_int_t) - 1) / sizeof(sef_int_t) * sizeof(sef_int_t) + \
+     (1 + (data_stack_size) + (return_stack_size) + (control_flow_stack_size)) * sizeof(sef_int_t) + \
+     MAX_DICTIONARY_ENTRIES(memory_size) * sizeof(dictionary_entry_t))
+
+#define DEFAULT_STATE_SIZE STATE_SIZE(SEF_FORTH_MEMORY_SIZE, SEF_DATA_STACK_SIZE, SEF_RETURN_STACK_SIZE, SEF_CONTROL_FLOW_STACK_SIZE)
+
+// Point the regions of the state to the memory following it, with the sizes
+// of the options, or with the default ones if `options` is NULL or for its
+// fields set to 0. There must be room for sef_state_size bytes.
+void sef_state_set_regions(forth_state_t* fs, const sef_options_t* options);
+size_t sef_state_size(const sef_options_t* options);
+
+#if SEF_MAPPED_STATES
+// Map a state sized by the options and initialize it. With
+// SEF_STACK_GUARD_PAGES, each stack gets its own pages between two guard pages.
+// Return NULL if it couldn't be mapped.
+forth_state_t* sef_state_create(const sef_options_t* options);
+void sef_state_destroy(forth_state_t* fs);
+#endif
+
 void sef_state_init(forth_state_t* fs);
 
+// Reset the state to an empty dictionary, without any word registered.
+void sef_state_clear(forth_state_t* fs);
+
+// Init the state by compiling the system words from their source, which
+// sef_state_init does if SEF_PRECOMPILED_DICTIONARY is 0.
+void sef_compile_system_words(forth_state_t* fs);
+
 void sef_push_data(forth_state_t* fs, sef_int_t data);
 void sef_push_return(forth_state_t* fs, sef_int_t data);
 void sef_push_control_flow(forth_state_t* fs, sef_int_t data);
@@ -63,6 +154,11 @@ void sef_reset(forth_state_t* fs);
 void sef_abort(forth_state_t* fs);
 void sef_call_entry(forth_state_t* fs, dictionary_entry_t entry);
 
+// Calls func(fs, arg). If SEF_CATCH_SEGFAULTS is set and the Forth code run by
+// func segfaults, the state is aborted and this returns. Only the outermost
+// call arms a recovery point, nested calls cost nothing.
+void sef_call_with_segfault_recovery(forth_state_t* fs, void (*func)(forth_state_t*, const void*), const void* arg);
+
 #define SEF_ERROR_OUT(fs, error_txt...) \
     error_msg(error_txt);               \
     sef_abort(fs)                        
@@ -74,8 +170,16 @@ typedef enum {
     WTM_C_WORD         = 1 << 3,
     WTM_FORTH_WORD     = 1 << 4,
     WTM_CREATE         = 1 << 5,
+    WTM_RETURN_STACK_REACH = 3 << 6,
+    WTM_INLINE         = 1 << 8,
 } word_tag_mask;
 
+// The return stack reach of a word is the number of cells it might read from
+// the return stack beyond the ones it pushed itself, 1 meaning that it reads
+// its own return address. It is saturated to 3.
+#define RETURN_STACK_REACH_SHIFT 6
+#define MAX_RETURN_STACK_REACH 3
+
 #define WORD_KIND (WTM_C_WORD | WTM_FORTH_WORD | WTM_CREATE | WTM_DOES_EXECUTION)
 
 void sef_allot(forth_state_t* fs, size_t byte_requested);
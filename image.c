@@ -0,0 +1,352 @@
+#include "private_api.h"
+#include "string.h"
+#include "stdio.h"
+
+#if SEF_IMAGE
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#endif
+
+// An image is made of a header, of a bitmap with a bit set for each cell of
+// memory pointing in the state, and of the cells of the memory addressed by
+// HERE, up to HERE. The cells pointing in the state, such as the links between
+// entries or the addresses compiled in colon definitions, are written as
+// offsets from the start of the state so that an image can be loaded in a state
+// at another address. A cell holding a number that happens to be an address in
+// the state is moved too, which is very unlikely as the state is at a random
+// address.
+
+#define IMAGE_MAGIC "SEFIMAGE"
+#define IMAGE_VERSION 2
+#define NO_ENTRY ((sef_unsigned_t) -1)
+#define NO_CFUNC ((sef_unsigned_t) -1)
+
+struct image_header_s {
+    char magic[8];
+    // The image can only be loaded by a build of SEForth with the same layout
+    // of the state and the same operation codes.
+    sef_unsigned_t version;
+    sef_unsigned_t cell_size;
+    sef_unsigned_t state_size;
+    sef_unsigned_t opcode_count;
+    sef_unsigned_t used_cells;
+    // Registers, with the pointers written as offsets
+    sef_unsigned_t here;
+    sef_unsigned_t last_dictionary_entry;
+    sef_unsigned_t base;
+    sef_unsigned_t search_order[SEARCH_ORDER_MAX];
+    sef_unsigned_t search_order_size;
+    sef_unsigned_t current_wordlist;
+    sef_unsigned_t wordlist_count;
+    sef_unsigned_t optimized_cells;
+    sef_unsigned_t word_cache[WORD_IN_CACHE_COUNT];
+};
+
+static bool points_in_state(forth_state_t* fs, sef_unsigned_t value) {
+    return value >= (sef_unsigned_t) fs && value < (sef_unsigned_t) fs + fs->size;
+}
+
+static sef_unsigned_t to_offset(forth_state_t* fs, const void* p) {
+    return p == NULL ? NO_ENTRY : (sef_unsigned_t) p - (sef_unsigned_t) fs;
+}
+
+static void* from_offset(forth_state_t* fs, sef_unsigned_t offset) {
+    return offset == NO_ENTRY ? NULL : (uint8_t*) fs + offset;
+}
+
+// The bitmap is padded to keep the cells after it aligned.
+static size_t bitmap_size(size_t used_cells) {
+    size_t cells = (used_cells + 8 * sizeof(sef_int_t) - 1) / (8 * sizeof(sef_int_t));
+    return cells * sizeof(sef_int_t);
+}
+
+static bool is_marked(const uint8_t* bitmap, size_t cell) {
+    return bitmap[cell / 8] & (1 << (cell % 8));
+}
+
+static void unmark(uint8_t* bitmap, size_t cell) {
+    bitmap[cell / 8] &= ~(1 << (cell % 8));
+}
+
+static void fill_header(forth_state_t* fs, struct image_header_s* header, size_t used_cells) {
+    memset(header, 0, sizeof(struct image_header_s));
+    memcpy(header->magic, IMAGE_MAGIC, sizeof(header->magic));
+    header->version = IMAGE_VERSION;
+    header->cell_size = sizeof(sef_int_t);
+    header->state_size = sizeof(forth_state_t);
+    header->opcode_count = OP_COUNT;
+    header->used_cells = used_cells;
+    header->here = to_offset(fs, fs->here.byte);
+    header->last_dictionary_entry = to_offset(fs, fs->last_dictionary_entry);
+    header->base = fs->base;
+    for (sef_int_t i=0; i<fs->search_order_size; i++) {
+        header->search_order[i] = fs->search_order[i];
+    }
+    header->search_order_size = fs->search_order_size;
+    header->current_wordlist = fs->current_wordlist;
+    header->wordlist_count = fs->wordlist_count;
+    header->optimized_cells = fs->optimized_cells;
+    for (size_t i=0; i<WORD_IN_CACHE_COUNT; i++) {
+        header->word_cache[i] = to_offset(fs, fs->word_cache[i]);
+    }
+}
+
+static bool header_matches(forth_state_t* fs, const struct image_header_s* header) {
+    return memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == IMAGE_VERSION &&
+        header->cell_size == sizeof(sef_int_t) &&
+        header->state_size == sizeof(forth_state_t) &&
+        header->opcode_count == OP_COUNT &&
+        header->used_cells <= fs->forth_memory_size / sizeof(sef_int_t) &&
+        header->here >= STATE_HEADER_SIZE &&
+        header->here <= STATE_HEADER_SIZE + header->used_cells * sizeof(sef_int_t) &&
+        header->search_order_size <= SEARCH_ORDER_MAX;
+}
+
+/* -------------------------------- C words --------------------------------- */
+
+// The system C words are numbered by their place in the tables of C_func.c,
+// parser.c and block_c_func.c, in that order.
+static const char* (*const system_cfunc_tables[])(size_t index, cfunc* func) = {
+    sef_default_cfunc_at,
+    sef_parser_cfunc_at,
+    sef_block_cfunc_at,
+};
+#define SYSTEM_CFUNC_TABLES (sizeof(system_cfunc_tables) / sizeof(system_cfunc_tables[0]))
+
+// Number of the system C word with the given function, or NO_CFUNC.
+static sef_unsigned_t system_cfunc_number(cfunc func) {
+    sef_unsigned_t number = 0;
+    for (size_t table=0; table<SYSTEM_CFUNC_TABLES; table++) {
+        cfunc table_func;
+        for (size_t i=0; system_cfunc_tables[table](i, &table_func) != NULL; i++, number++) {
+            if (table_func == func) {
+                return number;
+            }
+        }
+    }
+    return NO_CFUNC;
+}
+
+// Name of the system C word with the given number, whose function is written
+// in `func`, or NULL if there is none.
+static const char* system_cfunc_of_number(sef_unsigned_t number, cfunc* func) {
+    for (size_t table=0; table<SYSTEM_CFUNC_TABLES; table++) {
+        const char* name;
+        for (size_t i=0; (name = system_cfunc_tables[table](i, func)) != NULL; i++) {
+            if (number-- == 0) {
+                return name;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* --------------------------------- Saving --------------------------------- */
+
+uint8_t* sef_image_encode(forth_state_t* fs, size_t* size) {
+    if (fs->compiling) {
+        error_msg("Can't save an image while compiling.\n");
+        return NULL;
+    }
+#if SEF_SHARED_DICTIONARY
+    if (fs->shared_dictionary != NULL) {
+        error_msg("Can't save an image of a state using a shared dictionary.\n");
+        return NULL;
+    }
+#endif
+    size_t used_cells = (fs->here.byte - fs->forth_memory + sizeof(sef_int_t) - 1) / sizeof(sef_int_t);
+    size_t bitmap_bytes = bitmap_size(used_cells);
+    *size = sizeof(struct image_header_s) + bitmap_bytes + used_cells * sizeof(sef_unsigned_t);
+    uint8_t* image = calloc(*size, 1);
+    if (image == NULL) {
+        return NULL;
+    }
+    fill_header(fs, (struct image_header_s*) image, used_cells);
+    uint8_t* bitmap = image + sizeof(struct image_header_s);
+    sef_unsigned_t* cells = (sef_unsigned_t*) (bitmap + bitmap_bytes);
+    memcpy(cells, fs->forth_memory, used_cells * sizeof(sef_unsigned_t));
+    for (size_t i=0; i<used_cells; i++) {
+        if (points_in_state(fs, cells[i])) {
+            cells[i] -= (sef_unsigned_t) fs;
+            bitmap[i / 8] |= 1 << (i % 8);
+        }
+    }
+    // The functions of system C words are replaced by their number, to bind
+    // them again when the image is loaded. The machine code made by the JIT
+    // isn't kept, only the number of cells it was compiled from, to compile the
+    // word again once loaded.
+    for (dictionary_entry_t entry = fs->last_dictionary_entry; entry != NULL; entry = *sef_get_previous_entry(entry)) {
+        sef_int_t tags = *sef_get_word_tag_field(entry);
+        if (tags & WTM_C_WORD) {
+            sef_int_t* parameter = sef_get_entry_parameter(entry);
+            size_t index = parameter - (sef_int_t*) fs->forth_memory;
+            cells[index] = tags & WTM_SYSTEM_WORD ? system_cfunc_number((cfunc) *parameter) : NO_CFUNC;
+            unmark(bitmap, index);
+        }
+#if SEF_JIT_ENABLED
+        if (*sef_get_entry_code_field(entry) == OP_DONATIVE) {
+            size_t special_parameters = sef_get_entry_special_parameters(entry) - (sef_int_t*) fs->forth_memory;
+            cells[special_parameters] = sef_jit_body_cells(entry);
+            unmark(bitmap, special_parameters);
+        }
+#endif
+    }
+    return image;
+}
+
+/* --------------------------------- Loading -------------------------------- */
+
+static void unbound_cfunc(forth_state_t* fs) {
+    SEF_ERROR_OUT(fs, "This C word comes from an image and hasn't been registered again.\n");
+}
+
+// The system C words are bound again to the function at the same place in the
+// tables of this build. Their names aren't enough, as the run-time and the
+// compile-time POSTPONE share theirs. The other C words fail until they are
+// registered again by the user of the API.
+static void bind_c_words(forth_state_t* fs) {
+    for (dictionary_entry_t entry = fs->last_dictionary_entry; entry != NULL; entry = *sef_get_previous_entry(entry)) {
+        if (!(*sef_get_word_tag_field(entry) & WTM_C_WORD)) {
+            continue;
+        }
+        sef_int_t* parameter = sef_get_entry_parameter(entry);
+        cfunc func;
+        const char* name = system_cfunc_of_number(*parameter, &func);
+        if (name == NULL || strcmp(name, sef_get_entry_name(entry)) != 0) {
+            func = unbound_cfunc;
+            *sef_get_entry_code_field(entry) = OP_CFUNC;
+        }
+        *parameter = (sef_int_t) func;
+    }
+}
+
+#if SEF_JIT_ENABLED
+// The words compiled by the JIT when the image was saved are compiled again,
+// from the oldest so that the words they call are already compiled.
+static void compile_native_words(forth_state_t* fs) {
+    sef_follow_dictionary_changes(fs);
+    for (sef_int_t i=0; i<fs->entry_count; i++) {
+        dictionary_entry_t entry = fs->entries[i];
+        if (*sef_get_entry_code_field(entry) == OP_DONATIVE) {
+            sef_int_t* special_parameters = sef_get_entry_special_parameters(entry);
+            sef_int_t* body_end = (sef_int_t*) sef_get_entry_parameter(entry) + *special_parameters;
+            *sef_get_entry_code_field(entry) = OP_DOCOL;
+            *special_parameters = 0;
+            sef_jit_compile(fs, entry, body_end);
+        }
+    }
+}
+#endif
+
+bool sef_image_decode(forth_state_t* fs, const uint8_t* image, size_t size) {
+    const struct image_header_s* header = (const struct image_header_s*) image;
+    if (size < sizeof(struct image_header_s) || !header_matches(fs, header)) {
+        return false;
+    }
+    size_t bitmap_bytes = bitmap_size(header->used_cells);
+    if (size != sizeof(struct image_header_s) + bitmap_bytes + header->used_cells * sizeof(sef_unsigned_t)) {
+        return false;
+    }
+    const uint8_t* bitmap = image + sizeof(struct image_header_s);
+    const sef_unsigned_t* cells = (const sef_unsigned_t*) (bitmap + bitmap_bytes);
+
+    sef_state_clear(fs);
+    sef_unsigned_t* memory = (sef_unsigned_t*) fs->forth_memory;
+    for (size_t i=0; i<header->used_cells; i++) {
+        memory[i] = is_marked(bitmap, i) ? cells[i] + (sef_unsigned_t) fs : cells[i];
+    }
+    fs->here.byte = from_offset(fs, header->here);
+    // As the last indexed entry was cleared, the indexes of the dictionary are
+    // built again from the last entry when a word is first looked up.
+    fs->last_dictionary_entry = from_offset(fs, header->last_dictionary_entry);
+    fs->base = header->base;
+    for (sef_unsigned_t i=0; i<header->search_order_size; i++) {
+        fs->search_order[i] = header->search_order[i];
+    }
+    fs->search_order_size = header->search_order_size;
+    fs->current_wordlist = header->current_wordlist;
+    fs->wordlist_count = header->wordlist_count;
+    fs->optimized_cells = header->optimized_cells;
+    for (size_t i=0; i<WORD_IN_CACHE_COUNT; i++) {
+        fs->word_cache[i] = from_offset(fs, header->word_cache[i]);
+    }
+    bind_c_words(fs);
+#if SEF_JIT_ENABLED
+    compile_native_words(fs);
+#endif
+    fs->compiling_system_words = false;
+    return true;
+}
+
+#if SEF_IMAGE
+bool sef_image_save(forth_state_t* fs, const char* path) {
+    size_t size;
+    uint8_t* image = sef_image_encode(fs, &size);
+    FILE* f = image != NULL ? fopen(path, "wb") : NULL;
+    bool ok = f != NULL && fwrite(image, 1, size, f) == size;
+    if (f != NULL) {
+        ok = fclose(f) == 0 && ok;
+    }
+    free(image);
+    if (!ok) {
+        error_msg("Can't write the image %s.\n", path);
+    }
+    return ok;
+}
+
+bool sef_image_load(forth_state_t* fs, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        error_msg("Can't open the image %s.\n", path);
+        return false;
+    }
+    struct stat file_stat;
+    void* image = MAP_FAILED;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+        image = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (image == MAP_FAILED) {
+        error_msg("Can't map the image %s.\n", path);
+        return false;
+    }
+    bool ok = sef_image_decode(fs, image, file_stat.st_size);
+    munmap(image, file_stat.st_size);
+    if (!ok) {
+        error_msg("%s isn't an image of this build of SEForth.\n", path);
+    }
+    return ok;
+}
+
+bool sef_image_rebind_cfunc(forth_state_t* fs, const char* name, cfunc func, bool is_immediate) {
+    dictionary_entry_t entry = sef_find_entry(fs, name, strlen(name));
+    if (entry == NULL || *sef_get_entry_code_field(entry) != OP_CFUNC) {
+        return false;
+    }
+    sef_int_t* parameter = sef_get_entry_parameter(entry);
+    if (*parameter != (sef_int_t) unbound_cfunc) {
+        return false;
+    }
+    *parameter = (sef_int_t) func;
+    if (is_immediate) {
+        *sef_get_word_tag_field(entry) |= WTM_IMMEDIATE;
+    }
+    return true;
+}
+
+/* ------------------------------- Forth word ------------------------------- */
+
+// save-image
+void sef_save_image_word(forth_state_t* fs) {
+    sef_int_t path_size = sef_pop_data(fs);
+    const char* path_forth = (const char*) sef_pop_data(fs);
+    char path[path_size+1]; // Convert forth string to C string
+    memcpy(path, path_forth, path_size);
+    path[path_size] = 0;
+    sef_push_data(fs, sef_image_save(fs, path) ? 0 : -1);
+}
+#endif
+
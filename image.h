@@ -0,0 +1,34 @@
+#include "private_api.h"
+#ifndef IMAGE_H
+#define IMAGE_H
+
+// Return an image of the state, allocated with malloc, and write its size in
+// `size`. It holds the used part of the memory addressed by HERE and the
+// registers needed to find the words in it, and the cells pointing in the
+// state are written relative to its start. Return NULL if it couldn't be made.
+uint8_t* sef_image_encode(forth_state_t* fs, size_t* size);
+
+// Initialize the state from an image made by sef_image_encode, in place of
+// sef_state_init. The C words of the system are bound again by name. Return
+// false if it isn't an image of this build of SEForth.
+bool sef_image_decode(forth_state_t* fs, const uint8_t* image, size_t size);
+
+#if SEF_IMAGE
+// Write an image of the state to the file at `path`. Return false if it
+// couldn't be written.
+bool sef_image_save(forth_state_t* fs, const char* path);
+
+// Initialize the state from an image written by sef_image_save. Return false
+// if the file isn't an image of this build of SEForth.
+bool sef_image_load(forth_state_t* fs, const char* path);
+
+// If the C word `name` was loaded from an image without a function to bind it
+// to, bind it to `func` and return true. Otherwise, return false.
+bool sef_image_rebind_cfunc(forth_state_t* fs, const char* name, void (*func)(forth_state_t*), bool is_immediate);
+
+// save-image
+void sef_save_image_word(forth_state_t* fs);
+#endif
+
+#endif
+
@@ -0,0 +1,1017 @@
+#include "private_api.h"
+
+#if SEF_JIT_ENABLED
+#include "stdint.h"
+#include "string.h"
+#include "sys/mman.h"
+
+// The machine code of a word keeps the registers of the threaded engine in
+// callee-saved registers: r12 is the data stack pointer, r13 the top of the
+// data stack, r14 the return stack pointer and r15 the state. They follow the
+// same conventions as in the threaded engine and are saved into the state
+// before calling any C function. Everything that has no template, such as the
+// calls to words defined in C, goes through helper functions.
+
+/* ------------------------------- Code buffer ------------------------------ */
+
+// Size of the buffer holding the machine code of all compiled words. It is
+// shared by all states. Once it is full, new words are left to the threaded
+// engine.
+#define JIT_BUFFER_SIZE (4 * 1024 * 1024)
+
+// Upper bounds of the machine code emitted for each cell of a definition and
+// for the prologue and epilogues.
+#define MAX_CODE_PER_CELL 256
+#define MAX_CODE_AROUND_BODY 512
+#define CODE_HEADER_SIZE 16
+
+static uint8_t* jit_buffer = NULL;
+static size_t jit_buffer_used = 0;
+static bool jit_buffer_unavailable = false;
+
+static bool reserve_jit_buffer(void) {
+    if (jit_buffer != NULL) {
+        return true;
+    }
+    if (jit_buffer_unavailable) {
+        return false;
+    }
+    void* buffer = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        warn_msg("Can't map memory for the JIT, words will be interpreted.\n");
+        jit_buffer_unavailable = true;
+        return false;
+    }
+    jit_buffer = buffer;
+    return true;
+}
+
+/* ----------------------------- Code emission ------------------------------ */
+
+// Places the code can jump to, besides the cells of the definition.
+enum jit_label {
+    LABEL_START,          // Start of the function, called by recursive calls
+    LABEL_RETURN,         // Saves the registers and returns true
+    LABEL_ABORT,          // Returns false, the state has been aborted
+    LABEL_DATA_STACK_ERROR,
+    LABEL_RETURN_STACK_ERROR,
+    LABEL_COUNT,
+};
+
+// Opcodes of the jumps, the conditional ones are prefixed by 0x0F.
+enum jump_opcode {
+    JNO = 0x81,
+    JAE = 0x83,
+    JZ = 0x84,
+    JNZ = 0x85,
+    CALL = 0xE8,
+    JMP = 0xE9,
+};
+
+struct jump_s {
+    size_t at;     // Offset of the rel32 operand
+    size_t target; // Index of a cell, or the number of cells plus a label
+};
+
+// Code setting the code pointer to a cell before jumping to a stack error.
+struct error_stub_s {
+    sef_int_t* cell;
+    enum jit_label error;
+};
+
+struct jit_s {
+    forth_state_t* fs;
+    dictionary_entry_t entry;
+    sef_int_t* body;
+    size_t body_cells;
+    sef_int_t* cell; // Cell being compiled
+    uint8_t* code;
+    size_t size;
+    size_t capacity;
+    // Offset of the code of each cell, of each label and of each error stub,
+    // SIZE_MAX if none.
+    size_t* targets;
+    struct jump_s* jumps;
+    size_t jump_count;
+    struct error_stub_s* error_stubs;
+    size_t error_stub_count;
+    // Cells after the innermost loops, where LEAVE jumps to.
+    size_t* loop_ends;
+    size_t loop_depth;
+    bool failed;
+};
+
+static void emit(struct jit_s* jit, const uint8_t* bytes, size_t n) {
+    if (jit->size + n > jit->capacity) {
+        jit->failed = true;
+        return;
+    }
+    memcpy(jit->code + jit->size, bytes, n);
+    jit->size += n;
+}
+
+#define EMIT(jit, ...) emit(jit, (const uint8_t[]) {__VA_ARGS__}, sizeof((const uint8_t[]) {__VA_ARGS__}))
+
+static void emit_imm32(struct jit_s* jit, int32_t value) {
+    emit(jit, (const uint8_t*) &value, sizeof(value));
+}
+
+static void emit_imm64(struct jit_s* jit, uint64_t value) {
+    emit(jit, (const uint8_t*) &value, sizeof(value));
+}
+
+static size_t label(struct jit_s* jit, enum jit_label label) {
+    return jit->body_cells + label;
+}
+
+static void place_label(struct jit_s* jit, enum jit_label label_to_place) {
+    jit->targets[label(jit, label_to_place)] = jit->size;
+}
+
+// Emits a jump or a call to a cell or a label, its offset is set once all
+// the code has been emitted.
+static void emit_jump(struct jit_s* jit, enum jump_opcode opcode, size_t target) {
+    if (opcode == JMP || opcode == CALL) {
+        EMIT(jit, opcode);
+    } else {
+        EMIT(jit, 0x0F, opcode);
+    }
+    jit->jumps[jit->jump_count].at = jit->size;
+    jit->jumps[jit->jump_count].target = target;
+    jit->jump_count++;
+    emit_imm32(jit, 0);
+}
+
+static bool resolve_jumps(struct jit_s* jit) {
+    for (size_t i=0; i<jit->jump_count; i++) {
+        size_t target = jit->targets[jit->jumps[i].target];
+        if (target == SIZE_MAX) {
+            return false;
+        }
+        int32_t offset = (int32_t) (target - (jit->jumps[i].at + sizeof(int32_t)));
+        memcpy(jit->code + jit->jumps[i].at, &offset, sizeof(offset));
+    }
+    return true;
+}
+
+/* --------------------------- Registers handling --------------------------- */
+
+#define FIELD_DISPLACEMENT(field) ((int32_t) offsetof(forth_state_t, field))
+
+static void emit_push_callee_saved(struct jit_s* jit) {
+    EMIT(jit, 0x53);       // push rbx, keeps the stack aligned on 16 bytes
+    EMIT(jit, 0x41, 0x54); // push r12
+    EMIT(jit, 0x41, 0x55); // push r13
+    EMIT(jit, 0x41, 0x56); // push r14
+    EMIT(jit, 0x41, 0x57); // push r15
+}
+
+static void emit_pop_callee_saved(struct jit_s* jit) {
+    EMIT(jit, 0x41, 0x5F); // pop r15
+    EMIT(jit, 0x41, 0x5E); // pop r14
+    EMIT(jit, 0x41, 0x5D); // pop r13
+    EMIT(jit, 0x41, 0x5C); // pop r12
+    EMIT(jit, 0x5B);       // pop rbx
+}
+
+static void emit_load_registers(struct jit_s* jit) {
+    EMIT(jit, 0x49, 0x8B, 0x87);             // mov rax, [r15 + data_stack_index]
+    emit_imm32(jit, FIELD_DISPLACEMENT(data_stack_index));
+    EMIT(jit, 0x49, 0xBC);                   // mov r12, data_stack
+    emit_imm64(jit, (uint64_t) jit->fs->data_stack);
+    EMIT(jit, 0x4D, 0x8D, 0x24, 0xC4);       // lea r12, [r12 + rax * 8]
+    EMIT(jit, 0x4D, 0x8B, 0x6C, 0x24, 0xF8); // mov r13, [r12 - 8]
+    EMIT(jit, 0x49, 0x8B, 0x87);             // mov rax, [r15 + return_stack_index]
+    emit_imm32(jit, FIELD_DISPLACEMENT(return_stack_index));
+    EMIT(jit, 0x49, 0xBE);                   // mov r14, return_stack
+    emit_imm64(jit, (uint64_t) jit->fs->return_stack);
+    EMIT(jit, 0x4D, 0x8D, 0x34, 0xC6);       // lea r14, [r14 + rax * 8]
+}
+
+static void emit_save_registers(struct jit_s* jit) {
+    EMIT(jit, 0x4D, 0x89, 0x6C, 0x24, 0xF8); // mov [r12 - 8], r13
+    EMIT(jit, 0x4C, 0x89, 0xE0);             // mov rax, r12
+    EMIT(jit, 0x48, 0xB9);                   // mov rcx, data_stack
+    emit_imm64(jit, (uint64_t) jit->fs->data_stack);
+    EMIT(jit, 0x48, 0x29, 0xC8);             // sub rax, rcx
+    EMIT(jit, 0x48, 0xC1, 0xF8, 0x03);       // sar rax, 3
+    EMIT(jit, 0x49, 0x89, 0x87);             // mov [r15 + data_stack_index], rax
+    emit_imm32(jit, FIELD_DISPLACEMENT(data_stack_index));
+    EMIT(jit, 0x4C, 0x89, 0xF0);             // mov rax, r14
+    EMIT(jit, 0x48, 0xB9);                   // mov rcx, return_stack
+    emit_imm64(jit, (uint64_t) jit->fs->return_stack);
+    EMIT(jit, 0x48, 0x29, 0xC8);             // sub rax, rcx
+    EMIT(jit, 0x48, 0xC1, 0xF8, 0x03);       // sar rax, 3
+    EMIT(jit, 0x49, 0x89, 0x87);             // mov [r15 + return_stack_index], rax
+    emit_imm32(jit, FIELD_DISPLACEMENT(return_stack_index));
+}
+
+static void emit_save_code_pointer(struct jit_s* jit, sef_int_t* cell) {
+    EMIT(jit, 0x48, 0xB8);       // mov rax, cell
+    emit_imm64(jit, (uint64_t) cell);
+    EMIT(jit, 0x49, 0x89, 0x87); // mov [r15 + code_pointer], rax
+    emit_imm32(jit, FIELD_DISPLACEMENT(code_pointer));
+}
+
+// The words that might segfault save the registers first so that the segfault
+// handler can tell which word caused it and print a correct stack trace.
+static void emit_save_registers_for_segfault(struct jit_s* jit) {
+#if SEF_CATCH_SEGFAULTS
+    emit_save_code_pointer(jit, jit->cell);
+    emit_save_registers(jit);
+#else
+    UNUSED(jit);
+#endif
+}
+
+static void emit_push_tos(struct jit_s* jit) {
+    EMIT(jit, 0x4D, 0x89, 0x6C, 0x24, 0xF8); // mov [r12 - 8], r13
+    EMIT(jit, 0x49, 0x83, 0xC4, 0x08);       // add r12, 8
+}
+
+static void emit_drop(struct jit_s* jit) {
+    EMIT(jit, 0x49, 0x83, 0xEC, 0x08);       // sub r12, 8
+    EMIT(jit, 0x4D, 0x8B, 0x6C, 0x24, 0xF8); // mov r13, [r12 - 8]
+}
+
+static void emit_two_drop(struct jit_s* jit) {
+    EMIT(jit, 0x49, 0x83, 0xEC, 0x10);       // sub r12, 16
+    EMIT(jit, 0x4D, 0x8B, 0x6C, 0x24, 0xF8); // mov r13, [r12 - 8]
+}
+
+static void emit_push_constant(struct jit_s* jit, sef_int_t value) {
+    emit_push_tos(jit);
+    EMIT(jit, 0x49, 0xBD); // mov r13, value
+    emit_imm64(jit, (uint64_t) value);
+}
+
+// Turns the flag set by the last comparison into a Forth flag in r13.
+static void emit_flag(struct jit_s* jit, uint8_t setcc) {
+    EMIT(jit, 0x0F, setcc, 0xC0);       // setcc al
+    EMIT(jit, 0x0F, 0xB6, 0xC0);        // movzx eax, al
+    EMIT(jit, 0x48, 0xF7, 0xD8);        // neg rax
+    EMIT(jit, 0x49, 0x89, 0xC5);        // mov r13, rax
+}
+
+// Compares the two cells at the top of the stack and replaces them with a flag.
+static void emit_comparison(struct jit_s* jit, uint8_t setcc) {
+    EMIT(jit, 0x49, 0x83, 0xEC, 0x08);       // sub r12, 8
+    EMIT(jit, 0x4D, 0x39, 0x6C, 0x24, 0xF8); // cmp [r12 - 8], r13
+    emit_flag(jit, setcc);
+}
+
+// Compares the top of the stack to 0 and replaces it with a flag.
+static void emit_comparison_with_0(struct jit_s* jit, uint8_t setcc) {
+    EMIT(jit, 0x4D, 0x85, 0xED); // test r13, r13
+    emit_flag(jit, setcc);
+}
+
+// Replaces the two cells at the top of the stack with the result of an
+// operation `op r13, [r12 - 8]`, given by its opcode bytes.
+static void emit_binary(struct jit_s* jit, const uint8_t* opcode, size_t opcode_size) {
+    EMIT(jit, 0x49, 0x83, 0xEC, 0x08); // sub r12, 8
+    EMIT(jit, 0x4D);
+    emit(jit, opcode, opcode_size);
+    EMIT(jit, 0x6C, 0x24, 0xF8);       // r13, [r12 - 8]
+}
+
+#define EMIT_BINARY(jit, ...) emit_binary(jit, (const uint8_t[]) {__VA_ARGS__}, sizeof((const uint8_t[]) {__VA_ARGS__}))
+
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+// Number of cells each template takes from and puts on the stacks, as in the
+// threaded engine. The stacks are checked before each template.
+static const struct {
+    uint8_t data_in, data_out, return_in, return_out;
+} stack_effects[OP_COUNT] = {
+    [OP_DOCREATE] = {0, 1, 0, 0},
+#if SEF_SHARED_DICTIONARY
+    [OP_DOSHAREDCREATE] = {0, 1, 0, 0},
+#endif
+    [OP_SWAP] = {2, 2, 0, 0},
+    [OP_ROT] = {3, 3, 0, 0},
+    [OP_DUP] = {1, 2, 0, 0},
+    [OP_DROP] = {1, 0, 0, 0},
+    [OP_TO_R] = {1, 0, 0, 1},
+    [OP_R_FROM] = {0, 1, 1, 0},
+    [OP_ADD] = {2, 1, 0, 0},
+    [OP_SUB] = {2, 1, 0, 0},
+    [OP_MULT] = {2, 1, 0, 0},
+    [OP_LESS_THAN] = {2, 1, 0, 0},
+    [OP_U_LESS_THAN] = {2, 1, 0, 0},
+    [OP_LESS0] = {1, 1, 0, 0},
+    [OP_EQ0] = {1, 1, 0, 0},
+    [OP_EQ] = {2, 1, 0, 0},
+    [OP_AND] = {2, 1, 0, 0},
+    [OP_OR] = {2, 1, 0, 0},
+    [OP_XOR] = {2, 1, 0, 0},
+    [OP_LSHIFT] = {2, 1, 0, 0},
+    [OP_RSHIFT] = {2, 1, 0, 0},
+    [OP_TWO_SLASH] = {1, 1, 0, 0},
+    [OP_ZERO_BRANCH] = {1, 0, 0, 0},
+    [OP_QUESTION_DO] = {2, 0, 0, 3},
+    [OP_DO] = {2, 0, 0, 3},
+    [OP_PLUS_LOOP] = {1, 0, 3, 3},
+    [OP_LOOP] = {0, 0, 3, 3},
+    [OP_I] = {0, 1, 1, 1},
+    [OP_J] = {0, 1, 4, 4},
+    [OP_UNLOOP] = {0, 0, 3, 0},
+    [OP_LEAVE] = {0, 0, 3, 0},
+    [OP_OF] = {2, 1, 0, 0},
+    [OP_LITERAL] = {0, 1, 0, 0},
+    [OP_CELLS] = {1, 1, 0, 0},
+    [OP_FETCH] = {1, 1, 0, 0},
+    [OP_STORE] = {2, 0, 0, 0},
+    [OP_CFETCH] = {1, 1, 0, 0},
+    [OP_CSTORE] = {2, 0, 0, 0},
+    [OP_EXECUTE] = {1, 0, 0, 0},
+#if SEF_NATIVE_CORE_WORDS
+    [OP_TWO_DUP] = {2, 4, 0, 0},
+    [OP_TWO_DROP] = {2, 0, 0, 0},
+    [OP_NIP] = {2, 1, 0, 0},
+    [OP_OVER] = {2, 3, 0, 0},
+    [OP_TUCK] = {2, 3, 0, 0},
+    [OP_ONE_PLUS] = {1, 1, 0, 0},
+    [OP_ONE_MINUS] = {1, 1, 0, 0},
+    [OP_NOT_EQ] = {2, 1, 0, 0},
+    [OP_NOT_EQ0] = {1, 1, 0, 0},
+    [OP_GREATER_THAN] = {2, 1, 0, 0},
+    [OP_GREATER0] = {1, 1, 0, 0},
+    [OP_MAX] = {2, 1, 0, 0},
+    [OP_MIN] = {2, 1, 0, 0},
+    [OP_NEGATE] = {1, 1, 0, 0},
+    [OP_INVERT] = {1, 1, 0, 0},
+    [OP_PLUS_STORE] = {2, 0, 0, 0},
+    [OP_CELL_PLUS] = {1, 1, 0, 0},
+#endif
+};
+
+// Same check as in the threaded engine, on the distance in bytes between the
+// stack pointer and the start of the stack.
+static void emit_stack_check(struct jit_s* jit, bool return_stack, size_t in, size_t out) {
+    if (in == 0 && out == 0) {
+        return;
+    }
+    sef_int_t* stack = return_stack ? jit->fs->return_stack : jit->fs->data_stack;
+    size_t stack_size = return_stack ? jit->fs->return_stack_size : jit->fs->data_stack_size;
+    if (return_stack) {
+        EMIT(jit, 0x4C, 0x89, 0xF0); // mov rax, r14
+    } else {
+        EMIT(jit, 0x4C, 0x89, 0xE0); // mov rax, r12
+    }
+    EMIT(jit, 0x48, 0xB9);           // mov rcx, stack + in
+    emit_imm64(jit, (uint64_t) (stack + in));
+    EMIT(jit, 0x48, 0x29, 0xC8);     // sub rax, rcx
+    EMIT(jit, 0x48, 0x3D);           // cmp rax, (stack_size - out) * 8
+    emit_imm32(jit, (int32_t) ((stack_size - out) * sizeof(sef_int_t)));
+    struct error_stub_s* stub = &jit->error_stubs[jit->error_stub_count];
+    stub->cell = jit->cell;
+    stub->error = return_stack ? LABEL_RETURN_STACK_ERROR : LABEL_DATA_STACK_ERROR;
+    emit_jump(jit, JAE, label(jit, LABEL_COUNT) + jit->error_stub_count);
+    jit->error_stub_count++;
+}
+
+static void emit_stack_checks(struct jit_s* jit, size_t data_in, size_t data_out, size_t return_in, size_t return_out) {
+    if (SEF_HAS_GUARD_PAGES(jit->fs)) {
+        // Only the underflows of the data stack, the other overflows fault in
+        // the guard pages.
+        emit_stack_check(jit, false, data_in, 0);
+    } else if (SEF_STACK_INDEX_CHECKS) {
+        emit_stack_check(jit, false, data_in, data_out);
+        emit_stack_check(jit, true, return_in, return_out);
+    }
+}
+
+static void data_stack_error(forth_state_t* fs) {
+    SEF_ERROR_OUT(fs, "Stack 'data' out of bound. Resetting state.\n");
+}
+
+static void return_stack_error(forth_state_t* fs) {
+    SEF_ERROR_OUT(fs, "Stack 'return' out of bound. Resetting state.\n");
+}
+#else
+static void emit_stack_checks(struct jit_s* jit, size_t data_in, size_t data_out, size_t return_in, size_t return_out) {
+    UNUSED(jit);
+    UNUSED(data_in);
+    UNUSED(data_out);
+    UNUSED(return_in);
+    UNUSED(return_out);
+}
+#endif
+
+/* --------------------------------- Calls ---------------------------------- */
+
+// Runs a word without machine code from the machine code of another word,
+// the cell calling it being the given one. Return false if the state has been
+// aborted.
+static bool call_word(forth_state_t* fs, sef_int_t* cell, dictionary_entry_t entry) {
+    if ((*sef_get_word_tag_field(entry) & WORD_KIND) == WTM_C_WORD) {
+        sef_int_t return_stack_index = fs->return_stack_index;
+        fs->code_pointer = cell;
+        sef_exec_cfunc(fs, sef_get_entry_parameter(entry));
+        // A C word calling a Forth word, as POSTPONE does for immediate words,
+        // only points the code pointer to it. It is run now until it returns.
+        if (!fs->quit && fs->code_pointer != cell && fs->return_stack[return_stack_index] == (sef_int_t) cell) {
+            fs->return_stack[return_stack_index] = (sef_int_t) NULL;
+            fs->code_pointer++;
+            sef_run(fs);
+        }
+    } else {
+        fs->code_pointer = NULL;
+        sef_call_entry(fs, entry);
+        sef_run(fs);
+    }
+    return !fs->quit;
+}
+
+static bool call_cell(forth_state_t* fs, sef_int_t* cell) {
+    return call_word(fs, cell, (dictionary_entry_t) *cell);
+}
+
+static bool execute_top_of_stack(forth_state_t* fs, sef_int_t* cell) {
+    dictionary_entry_t entry = (dictionary_entry_t) sef_pop_data(fs);
+    return call_word(fs, cell, entry);
+}
+
+static bool tail_call(forth_state_t* fs, dictionary_entry_t entry) {
+    return call_word(fs, NULL, entry);
+}
+
+// Calls a helper with the state and the given argument. The machine code
+// returns false as well if the helper does.
+static void emit_helper_call(struct jit_s* jit, bool (*helper)(forth_state_t*, sef_int_t*), const void* argument) {
+    emit_save_registers(jit);
+    EMIT(jit, 0x4C, 0x89, 0xFF); // mov rdi, r15
+    EMIT(jit, 0x48, 0xBE);       // mov rsi, argument
+    emit_imm64(jit, (uint64_t) argument);
+    EMIT(jit, 0x48, 0xB8);       // mov rax, helper
+    emit_imm64(jit, (uint64_t) helper);
+    EMIT(jit, 0xFF, 0xD0);       // call rax
+    EMIT(jit, 0x84, 0xC0);       // test al, al
+    emit_jump(jit, JZ, label(jit, LABEL_ABORT));
+    emit_load_registers(jit);
+}
+
+static sef_int_t return_stack_reach(dictionary_entry_t entry) {
+    return (*sef_get_word_tag_field(entry) & WTM_RETURN_STACK_REACH) >> RETURN_STACK_REACH_SHIFT;
+}
+
+// Words called through a helper don't get the address of the cell calling
+// them as return address, they must not read it. C words with an operation
+// code of their own might read the cells after them and need a template.
+static bool can_call_through_helper(struct jit_s* jit, dictionary_entry_t entry) {
+    sef_int_t tags = *sef_get_word_tag_field(entry);
+    switch (tags & WORD_KIND) {
+        case WTM_C_WORD:
+            return *sef_get_entry_code_field(entry) == OP_CFUNC && entry != sef_get_word_from_cache(jit->fs, DOES);
+        case WTM_FORTH_WORD:
+            return return_stack_reach(entry) == 0;
+        case WTM_DOES_EXECUTION: {
+            void* does_code = (void*) *sef_get_entry_special_parameters(entry);
+            dictionary_entry_t defining_word = sef_try_to_find_entry(jit->fs, does_code);
+            return defining_word != NULL && return_stack_reach(defining_word) == 0;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool is_native(struct jit_s* jit, dictionary_entry_t entry) {
+    return entry == jit->entry || *sef_get_entry_code_field(entry) == OP_DONATIVE;
+}
+
+// Calls a word from the given cell. Words with machine code are called
+// directly, with the address of the cell pushed as return address as DOCOL
+// does.
+static bool emit_call(struct jit_s* jit, sef_int_t* cell, dictionary_entry_t entry) {
+    if (!is_native(jit, entry)) {
+        if (!can_call_through_helper(jit, entry)) {
+            return false;
+        }
+        emit_helper_call(jit, call_cell, cell);
+        return true;
+    }
+    emit_stack_checks(jit, 0, 0, 0, 1);
+    EMIT(jit, 0x48, 0xB8);             // mov rax, cell
+    emit_imm64(jit, (uint64_t) cell);
+    EMIT(jit, 0x49, 0x89, 0x06);       // mov [r14], rax
+    EMIT(jit, 0x49, 0x83, 0xC6, 0x08); // add r14, 8
+    emit_save_registers(jit);
+    if (entry == jit->entry) {
+        emit_jump(jit, CALL, label(jit, LABEL_START));
+    } else {
+        EMIT(jit, 0x48, 0xB8);         // mov rax, code
+        emit_imm64(jit, (uint64_t) *sef_get_entry_special_parameters(entry));
+        EMIT(jit, 0xFF, 0xD0);         // call rax
+    }
+    EMIT(jit, 0x84, 0xC0);             // test al, al
+    emit_jump(jit, JZ, label(jit, LABEL_ABORT));
+    emit_load_registers(jit);
+    EMIT(jit, 0x49, 0x83, 0xEE, 0x08); // sub r14, 8
+    return true;
+}
+
+// A branch to the start of another word is a tail call. The machine code of
+// the word called returns directly to our caller.
+static bool emit_tail_call(struct jit_s* jit, dictionary_entry_t entry) {
+    if (sef_try_to_find_entry(jit->fs, entry) != entry) {
+        return false;
+    }
+    if (!is_native(jit, entry) && !can_call_through_helper(jit, entry)) {
+        return false;
+    }
+    emit_save_registers(jit);
+    emit_pop_callee_saved(jit);
+    if (is_native(jit, entry)) {
+        EMIT(jit, 0x48, 0xB8);   // mov rax, code
+        emit_imm64(jit, (uint64_t) *sef_get_entry_special_parameters(entry));
+    } else {
+        EMIT(jit, 0x48, 0xBF);   // mov rdi, fs
+        emit_imm64(jit, (uint64_t) jit->fs);
+        EMIT(jit, 0x48, 0xBE);   // mov rsi, entry
+        emit_imm64(jit, (uint64_t) entry);
+        EMIT(jit, 0x48, 0xB8);   // mov rax, tail_call
+        emit_imm64(jit, (uint64_t) tail_call);
+    }
+    EMIT(jit, 0xFF, 0xE0);       // jmp rax
+    return true;
+}
+
+/* ------------------------------- Templates -------------------------------- */
+
+// Index of the cell a branch operand makes the code continue at.
+static bool branch_target(struct jit_s* jit, sef_int_t operand, size_t* target) {
+    sef_int_t* destination = (sef_int_t*) operand + 1;
+    if (destination < jit->body || destination >= jit->body + jit->body_cells) {
+        return false;
+    }
+    *target = destination - jit->body;
+    return true;
+}
+
+// Emits the code of the instruction in the given cell. Return the number of
+// cells used by the instruction or 0 if it can't be compiled.
+static size_t compile_instruction(struct jit_s* jit, sef_int_t* cell) {
+    dictionary_entry_t entry = (dictionary_entry_t) *cell;
+    if (sef_try_to_find_entry(jit->fs, entry) != entry) {
+        return 0; // Not a word, might be data after an EXIT
+    }
+    // The cells after a superinstruction still hold the words it replaces
+    entry = sef_superinstruction_first_word(jit->fs, entry);
+    sef_int_t opcode = *sef_get_entry_code_field(entry);
+    if (opcode < 0 || opcode >= OP_COUNT) {
+        return 0;
+    }
+    bool has_operand = cell + 1 < jit->body + jit->body_cells;
+    sef_int_t operand = has_operand ? cell[1] : 0;
+    size_t target;
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+    emit_stack_checks(jit, stack_effects[opcode].data_in, stack_effects[opcode].data_out, stack_effects[opcode].return_in, stack_effects[opcode].return_out);
+#endif
+
+    switch (opcode) {
+        case OP_DOCREATE:
+#if SEF_SHARED_DICTIONARY
+        case OP_DOSHAREDCREATE:
+#endif
+            emit_push_constant(jit, (sef_int_t) sef_get_entry_body(jit->fs, entry));
+            return 1;
+        case OP_SWAP:
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            EMIT(jit, 0x4D, 0x89, 0x6C, 0x24, 0xF0); // mov [r12 - 16], r13
+            EMIT(jit, 0x49, 0x89, 0xC5);             // mov r13, rax
+            return 1;
+        case OP_ROT:
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xE8); // mov rax, [r12 - 24]
+            EMIT(jit, 0x49, 0x8B, 0x4C, 0x24, 0xF0); // mov rcx, [r12 - 16]
+            EMIT(jit, 0x49, 0x89, 0x4C, 0x24, 0xE8); // mov [r12 - 24], rcx
+            EMIT(jit, 0x4D, 0x89, 0x6C, 0x24, 0xF0); // mov [r12 - 16], r13
+            EMIT(jit, 0x49, 0x89, 0xC5);             // mov r13, rax
+            return 1;
+        case OP_DUP:
+            emit_push_tos(jit);
+            return 1;
+        case OP_DROP:
+            emit_drop(jit);
+            return 1;
+        case OP_TO_R:
+            EMIT(jit, 0x4D, 0x89, 0x2E);             // mov [r14], r13
+            EMIT(jit, 0x49, 0x83, 0xC6, 0x08);       // add r14, 8
+            emit_drop(jit);
+            return 1;
+        case OP_R_FROM:
+            emit_push_tos(jit);
+            EMIT(jit, 0x49, 0x83, 0xEE, 0x08);       // sub r14, 8
+            EMIT(jit, 0x4D, 0x8B, 0x2E);             // mov r13, [r14]
+            return 1;
+        case OP_ADD:
+            EMIT_BINARY(jit, 0x03);                  // add
+            return 1;
+        case OP_SUB:
+            EMIT(jit, 0x49, 0x83, 0xEC, 0x08);       // sub r12, 8
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF8); // mov rax, [r12 - 8]
+            EMIT(jit, 0x4C, 0x29, 0xE8);             // sub rax, r13
+            EMIT(jit, 0x49, 0x89, 0xC5);             // mov r13, rax
+            return 1;
+        case OP_MULT:
+            EMIT_BINARY(jit, 0x0F, 0xAF);            // imul
+            return 1;
+        case OP_LESS_THAN:
+            emit_comparison(jit, 0x9C);              // setl
+            return 1;
+        case OP_U_LESS_THAN:
+            emit_comparison(jit, 0x92);              // setb
+            return 1;
+        case OP_LESS0:
+            EMIT(jit, 0x49, 0xC1, 0xFD, 0x3F);       // sar r13, 63
+            return 1;
+        case OP_EQ0:
+            emit_comparison_with_0(jit, 0x94);       // sete
+            return 1;
+        case OP_EQ:
+            emit_comparison(jit, 0x94);              // sete
+            return 1;
+        case OP_AND:
+            EMIT_BINARY(jit, 0x23);                  // and
+            return 1;
+        case OP_OR:
+            EMIT_BINARY(jit, 0x0B);                  // or
+            return 1;
+        case OP_XOR:
+            EMIT_BINARY(jit, 0x33);                  // xor
+            return 1;
+        case OP_LSHIFT:
+        case OP_RSHIFT:
+            EMIT(jit, 0x49, 0x83, 0xEC, 0x08);       // sub r12, 8
+            EMIT(jit, 0x4C, 0x89, 0xE9);             // mov rcx, r13
+            EMIT(jit, 0x4D, 0x8B, 0x6C, 0x24, 0xF8); // mov r13, [r12 - 8]
+            if (opcode == OP_LSHIFT) {
+                EMIT(jit, 0x49, 0xD3, 0xE5);         // shl r13, cl
+            } else {
+                EMIT(jit, 0x49, 0xD3, 0xED);         // shr r13, cl
+            }
+            return 1;
+        case OP_TWO_SLASH:
+            EMIT(jit, 0x49, 0xD1, 0xFD);             // sar r13, 1
+            return 1;
+        case OP_ZERO_BRANCH:
+            if (!has_operand || !branch_target(jit, operand, &target)) {
+                return 0;
+            }
+            EMIT(jit, 0x4C, 0x89, 0xE8);             // mov rax, r13
+            emit_drop(jit);
+            EMIT(jit, 0x48, 0x85, 0xC0);             // test rax, rax
+            emit_jump(jit, JZ, target);
+            return 2;
+        case OP_BRANCH:
+            if (!has_operand) {
+                return 0;
+            }
+            if (branch_target(jit, operand, &target)) {
+                emit_jump(jit, JMP, target);
+                return 2;
+            }
+            // The operand points to the cell before the parameters of the word
+            if (!emit_tail_call(jit, (dictionary_entry_t) ((sef_int_t*) operand + 1) - 3)) {
+                return 0;
+            }
+            return 2;
+        case OP_QUESTION_DO:
+        case OP_DO:
+            if (!has_operand || !branch_target(jit, operand, &target)) {
+                return 0;
+            }
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            if (opcode == OP_QUESTION_DO) {
+                EMIT(jit, 0x4C, 0x39, 0xE8);         // cmp rax, r13
+                EMIT(jit, 0x75, 0x0E);               // jne start_loop
+                emit_two_drop(jit);
+                emit_jump(jit, JMP, target);
+                // start_loop:
+            }
+            EMIT(jit, 0x48, 0xBA);                   // mov rdx, end of loop address
+            emit_imm64(jit, (uint64_t) operand);
+            EMIT(jit, 0x49, 0x89, 0x16);             // mov [r14], rdx
+            EMIT(jit, 0x49, 0x89, 0x46, 0x08);       // mov [r14 + 8], rax
+            EMIT(jit, 0x4D, 0x89, 0x6E, 0x10);       // mov [r14 + 16], r13
+            EMIT(jit, 0x49, 0x83, 0xC6, 0x18);       // add r14, 24
+            emit_two_drop(jit);
+            jit->loop_ends[jit->loop_depth++] = target;
+            return 2;
+        case OP_LOOP:
+            if (!has_operand || !branch_target(jit, operand, &target) || jit->loop_depth == 0) {
+                return 0;
+            }
+            EMIT(jit, 0x49, 0x83, 0x46, 0xF8, 0x01); // add qword [r14 - 8], 1
+            EMIT(jit, 0x49, 0x8B, 0x46, 0xF8);       // mov rax, [r14 - 8]
+            EMIT(jit, 0x49, 0x3B, 0x46, 0xF0);       // cmp rax, [r14 - 16]
+            emit_jump(jit, JNZ, target);
+            EMIT(jit, 0x49, 0x83, 0xEE, 0x18);       // sub r14, 24
+            jit->loop_depth--;
+            return 2;
+        case OP_PLUS_LOOP:
+            if (!has_operand || !branch_target(jit, operand, &target) || jit->loop_depth == 0) {
+                return 0;
+            }
+            // The loop ends when adding the increment to the distance between
+            // the counter and the end value, offset by the smallest number,
+            // overflows.
+            EMIT(jit, 0x4C, 0x89, 0xE9);             // mov rcx, r13
+            emit_drop(jit);
+            EMIT(jit, 0x49, 0x8B, 0x46, 0xF8);       // mov rax, [r14 - 8]
+            EMIT(jit, 0x49, 0x2B, 0x46, 0xF0);       // sub rax, [r14 - 16]
+            EMIT(jit, 0x48, 0xBA);                   // mov rdx, min_int
+            emit_imm64(jit, (uint64_t) 1 << 63);
+            EMIT(jit, 0x48, 0x31, 0xD0);             // xor rax, rdx
+            EMIT(jit, 0x49, 0x01, 0x4E, 0xF8);       // add [r14 - 8], rcx
+            EMIT(jit, 0x48, 0x01, 0xC8);             // add rax, rcx
+            emit_jump(jit, JNO, target);
+            EMIT(jit, 0x49, 0x83, 0xEE, 0x18);       // sub r14, 24
+            jit->loop_depth--;
+            return 2;
+        case OP_I:
+            emit_push_tos(jit);
+            EMIT(jit, 0x4D, 0x8B, 0x6E, 0xF8);       // mov r13, [r14 - 8]
+            return 1;
+        case OP_J:
+            emit_push_tos(jit);
+            EMIT(jit, 0x4D, 0x8B, 0x6E, 0xE0);       // mov r13, [r14 - 32]
+            return 1;
+        case OP_UNLOOP:
+            EMIT(jit, 0x49, 0x83, 0xEE, 0x18);       // sub r14, 24
+            return 1;
+        case OP_LEAVE:
+            // Leaves the innermost loop, which matches the loop-sys on top of
+            // the return stack in any well-formed definition.
+            if (jit->loop_depth == 0) {
+                return 0;
+            }
+            EMIT(jit, 0x49, 0x83, 0xEE, 0x18);       // sub r14, 24
+            emit_jump(jit, JMP, jit->loop_ends[jit->loop_depth - 1]);
+            return 1;
+        case OP_OF:
+            if (!has_operand || !branch_target(jit, operand, &target)) {
+                return 0;
+            }
+            EMIT(jit, 0x4C, 0x89, 0xE8);             // mov rax, r13
+            emit_drop(jit);
+            EMIT(jit, 0x49, 0x39, 0xC5);             // cmp r13, rax
+            emit_jump(jit, JNZ, target);
+            emit_drop(jit);
+            return 2;
+        case OP_LITERAL:
+            if (!has_operand) {
+                return 0;
+            }
+            emit_push_constant(jit, operand);
+            return 2;
+        case OP_CELLS:
+            EMIT(jit, 0x49, 0xC1, 0xE5, 0x03);       // shl r13, 3
+            return 1;
+        case OP_FETCH:
+            emit_save_registers_for_segfault(jit);
+            EMIT(jit, 0x4D, 0x8B, 0x6D, 0x00);       // mov r13, [r13]
+            return 1;
+        case OP_STORE:
+            emit_save_registers_for_segfault(jit);
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            EMIT(jit, 0x49, 0x89, 0x45, 0x00);       // mov [r13], rax
+            emit_two_drop(jit);
+            return 1;
+        case OP_CFETCH:
+            emit_save_registers_for_segfault(jit);
+            EMIT(jit, 0x4D, 0x0F, 0xBE, 0x6D, 0x00); // movsx r13, byte [r13]
+            return 1;
+        case OP_CSTORE:
+            emit_save_registers_for_segfault(jit);
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            EMIT(jit, 0x41, 0x88, 0x45, 0x00);       // mov [r13], al
+            emit_two_drop(jit);
+            return 1;
+        case OP_EXIT:
+            emit_jump(jit, JMP, label(jit, LABEL_RETURN));
+            return 1;
+        case OP_EXECUTE:
+            emit_helper_call(jit, execute_top_of_stack, cell);
+            return 1;
+#if SEF_NATIVE_CORE_WORDS
+        case OP_TWO_DUP:
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            EMIT(jit, 0x4D, 0x89, 0x6C, 0x24, 0xF8); // mov [r12 - 8], r13
+            EMIT(jit, 0x49, 0x89, 0x04, 0x24);       // mov [r12], rax
+            EMIT(jit, 0x49, 0x83, 0xC4, 0x10);       // add r12, 16
+            return 1;
+        case OP_TWO_DROP:
+            emit_two_drop(jit);
+            return 1;
+        case OP_NIP:
+            EMIT(jit, 0x49, 0x83, 0xEC, 0x08);       // sub r12, 8
+            return 1;
+        case OP_OVER:
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            emit_push_tos(jit);
+            EMIT(jit, 0x49, 0x89, 0xC5);             // mov r13, rax
+            return 1;
+        case OP_TUCK:
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            EMIT(jit, 0x4D, 0x89, 0x6C, 0x24, 0xF0); // mov [r12 - 16], r13
+            EMIT(jit, 0x49, 0x89, 0x44, 0x24, 0xF8); // mov [r12 - 8], rax
+            EMIT(jit, 0x49, 0x83, 0xC4, 0x08);       // add r12, 8
+            return 1;
+        case OP_ONE_PLUS:
+            EMIT(jit, 0x49, 0x83, 0xC5, 0x01);       // add r13, 1
+            return 1;
+        case OP_ONE_MINUS:
+            EMIT(jit, 0x49, 0x83, 0xED, 0x01);       // sub r13, 1
+            return 1;
+        case OP_NOT_EQ:
+            emit_comparison(jit, 0x95);              // setne
+            return 1;
+        case OP_NOT_EQ0:
+            emit_comparison_with_0(jit, 0x95);       // setne
+            return 1;
+        case OP_GREATER_THAN:
+            emit_comparison(jit, 0x9F);              // setg
+            return 1;
+        case OP_GREATER0:
+            emit_comparison_with_0(jit, 0x9F);       // setg
+            return 1;
+        case OP_MAX:
+        case OP_MIN:
+            EMIT(jit, 0x49, 0x83, 0xEC, 0x08);       // sub r12, 8
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF8); // mov rax, [r12 - 8]
+            EMIT(jit, 0x4C, 0x39, 0xE8);             // cmp rax, r13
+            if (opcode == OP_MAX) {
+                EMIT(jit, 0x4C, 0x0F, 0x4D, 0xE8);   // cmovge r13, rax
+            } else {
+                EMIT(jit, 0x4C, 0x0F, 0x4C, 0xE8);   // cmovl r13, rax
+            }
+            return 1;
+        case OP_NEGATE:
+            EMIT(jit, 0x49, 0xF7, 0xDD);             // neg r13
+            return 1;
+        case OP_INVERT:
+            EMIT(jit, 0x49, 0xF7, 0xD5);             // not r13
+            return 1;
+        case OP_PLUS_STORE:
+            emit_save_registers_for_segfault(jit);
+            EMIT(jit, 0x49, 0x8B, 0x44, 0x24, 0xF0); // mov rax, [r12 - 16]
+            EMIT(jit, 0x49, 0x01, 0x45, 0x00);       // add [r13], rax
+            emit_two_drop(jit);
+            return 1;
+        case OP_CELL_PLUS:
+            EMIT(jit, 0x49, 0x83, 0xC5, 0x08);       // add r13, 8
+            return 1;
+#endif
+        case OP_CFUNC:
+        case OP_DOCOL:
+        case OP_DODOES:
+#if SEF_SHARED_DICTIONARY
+        case OP_DOSHAREDDOES:
+#endif
+        case OP_DONATIVE:
+            return emit_call(jit, cell, entry) ? 1 : 0;
+        default:
+            return 0;
+    }
+}
+
+/* ------------------------------ Compilation ------------------------------- */
+
+static void compile_word(struct jit_s* jit) {
+    place_label(jit, LABEL_START);
+    emit_push_callee_saved(jit);
+    EMIT(jit, 0x49, 0xBF); // mov r15, fs
+    emit_imm64(jit, (uint64_t) jit->fs);
+    emit_load_registers(jit);
+
+    size_t i = 0;
+    while (i < jit->body_cells && !jit->failed) {
+        jit->targets[i] = jit->size;
+        jit->cell = jit->body + i;
+        size_t cells = compile_instruction(jit, jit->cell);
+        if (cells == 0) {
+            jit->failed = true;
+        }
+        i += cells;
+    }
+
+    place_label(jit, LABEL_RETURN);
+    emit_save_registers(jit);
+    EMIT(jit, 0xB8, 0x01, 0x00, 0x00, 0x00); // mov eax, 1
+    emit_pop_callee_saved(jit);
+    EMIT(jit, 0xC3);                         // ret
+
+    place_label(jit, LABEL_ABORT);
+    EMIT(jit, 0x31, 0xC0);                   // xor eax, eax
+    emit_pop_callee_saved(jit);
+    EMIT(jit, 0xC3);                         // ret
+
+#if SEF_STACK_INDEX_CHECKS || SEF_DATA_UNDERFLOW_CHECKS
+    for (size_t i=0; i<jit->error_stub_count; i++) {
+        jit->targets[label(jit, LABEL_COUNT) + i] = jit->size;
+        emit_save_code_pointer(jit, jit->error_stubs[i].cell);
+        emit_jump(jit, JMP, label(jit, jit->error_stubs[i].error));
+    }
+    void (*errors[])(forth_state_t*) = {data_stack_error, return_stack_error};
+    enum jit_label error_labels[] = {LABEL_DATA_STACK_ERROR, LABEL_RETURN_STACK_ERROR};
+    for (size_t error=0; error<2; error++) {
+        place_label(jit, error_labels[error]);
+        emit_save_registers(jit);
+        EMIT(jit, 0x4C, 0x89, 0xFF);         // mov rdi, r15
+        EMIT(jit, 0x48, 0xB8);               // mov rax, error function
+        emit_imm64(jit, (uint64_t) errors[error]);
+        EMIT(jit, 0xFF, 0xD0);               // call rax
+        emit_jump(jit, JMP, label(jit, LABEL_ABORT));
+    }
+#endif
+}
+
+// The fields of the state are addressed with 32-bit displacements and the
+// stacks are compared with 32-bit immediates.
+static bool state_fits_in_displacements(forth_state_t* fs) {
+    return sizeof(sef_int_t) == sizeof(int64_t) &&
+        offsetof(forth_state_t, return_stack_index) <= INT32_MAX &&
+        offsetof(forth_state_t, data_stack_index) <= INT32_MAX &&
+        offsetof(forth_state_t, code_pointer) <= INT32_MAX &&
+        fs->data_stack_size * sizeof(sef_int_t) <= INT32_MAX &&
+        fs->return_stack_size * sizeof(sef_int_t) <= INT32_MAX;
+}
+
+void sef_jit_compile(forth_state_t* fs, dictionary_entry_t entry, sef_int_t* body_end) {
+    if (!state_fits_in_displacements(fs) || *sef_get_entry_code_field(entry) != OP_DOCOL) {
+        return;
+    }
+    // The machine code doesn't return through the return address on the
+    // return stack, so it must not be read or changed.
+    if (return_stack_reach(entry) != 0 || !reserve_jit_buffer()) {
+        return;
+    }
+
+    struct jit_s jit;
+    memset(&jit, 0, sizeof(jit));
+    jit.fs = fs;
+    jit.entry = entry;
+    jit.body = sef_get_entry_parameter(entry);
+    jit.body_cells = body_end - jit.body;
+    // At most, an instruction checks two stacks, jumps, and checks a call.
+    // Each stack check has an error stub, which jumps once.
+    size_t max_checks = jit.body_cells * 2;
+    size_t max_targets = jit.body_cells + LABEL_COUNT + max_checks;
+    jit.capacity = jit.body_cells * MAX_CODE_PER_CELL + MAX_CODE_AROUND_BODY;
+    jit.code = malloc(jit.capacity);
+    jit.targets = malloc(max_targets * sizeof(size_t));
+    jit.jumps = malloc((jit.body_cells * 4 + max_checks + LABEL_COUNT) * sizeof(struct jump_s));
+    jit.error_stubs = malloc((max_checks + 1) * sizeof(struct error_stub_s));
+    jit.loop_ends = malloc((jit.body_cells + 1) * sizeof(size_t));
+    if (jit.code == NULL || jit.targets == NULL || jit.jumps == NULL || jit.error_stubs == NULL || jit.loop_ends == NULL) {
+        jit.failed = true;
+    } else {
+        for (size_t i=0; i<max_targets; i++) {
+            jit.targets[i] = SIZE_MAX;
+        }
+        compile_word(&jit);
+    }
+
+    // The number of cells compiled is kept before the machine code so that
+    // the word can be compiled again from an image.
+    if (!jit.failed && resolve_jumps(&jit) && jit_buffer_used + CODE_HEADER_SIZE + jit.size <= JIT_BUFFER_SIZE) {
+        uint8_t* code = jit_buffer + jit_buffer_used + CODE_HEADER_SIZE;
+        *(size_t*) (code - CODE_HEADER_SIZE) = jit.body_cells;
+        memcpy(code, jit.code, jit.size);
+        jit_buffer_used += (CODE_HEADER_SIZE + jit.size + 15) & ~(size_t) 15;
+        *sef_get_entry_special_parameters(entry) = (sef_int_t) code;
+        *sef_get_entry_code_field(entry) = OP_DONATIVE;
+        debug_msg("Compiled %s to %zu bytes of machine code.\n", sef_get_entry_name(entry), jit.size);
+    } else {
+        debug_msg("%s is left to the threaded engine.\n", sef_get_entry_name(entry));
+    }
+    free(jit.code);
+    free(jit.targets);
+    free(jit.jumps);
+    free(jit.error_stubs);
+    free(jit.loop_ends);
+}
+
+size_t sef_jit_body_cells(dictionary_entry_t entry) {
+    const uint8_t* code = (const uint8_t*) *sef_get_entry_special_parameters(entry);
+    return *(const size_t*) (code - CODE_HEADER_SIZE);
+}
+
+/* -------------------------------- Execution ------------------------------- */
+
+bool sef_jit_run(dictionary_entry_t entry) {
+    bool (*code)(void) = (bool (*)(void)) *sef_get_entry_special_parameters(entry);
+    return code();
+}
+
+void sef_jit_exec(forth_state_t* fs, dictionary_entry_t entry) {
+    if (fs->quit) {
+        return;
+    }
+    sef_push_return(fs, (sef_int_t) NULL);
+    if (sef_jit_run(entry)) {
+        sef_exit(fs);
+    }
+}
+#endif
+
@@ -0,0 +1,33 @@
+#include "private_api.h"
+#ifndef JIT_H
+#define JIT_H
+
+// The JIT emits x86-64 code following the System V calling convention and
+// relies on the threaded engine to run the words it doesn't compile.
+#if SEF_JIT && SEF_DIRECT_THREADING && defined(__x86_64__) && defined(__linux__)
+#define SEF_JIT_ENABLED 1
+#else
+#define SEF_JIT_ENABLED 0
+#endif
+
+#if SEF_JIT_ENABLED
+// Try to compile the given colon definition, whose body ends before
+// `body_end`, to machine code. On success, the code field of the entry is set
+// to OP_DONATIVE and its special parameters cell points to the machine code.
+// Otherwise, the word is left as it is.
+void sef_jit_compile(forth_state_t* fs, dictionary_entry_t entry, sef_int_t* body_end);
+
+// Number of cells of the body of a word compiled to machine code.
+size_t sef_jit_body_cells(dictionary_entry_t entry);
+
+// Run the machine code of a word. The return address of the word must have
+// been pushed on the return stack. Return false if the state was aborted.
+bool sef_jit_run(dictionary_entry_t entry);
+
+// Execute a word compiled to machine code as sef_call_entry would when no
+// word is running.
+void sef_jit_exec(forth_state_t* fs, dictionary_entry_t entry);
+#endif
+
+#endif
+
@@ -2,47 +2,45 @@
 #include "string.h"
 #include "stdlib.h"
 #include "stdio.h"
+#include "stdbool.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
 
-static void clear_shebang_from_first_line(char* file_content) {
-    if (strlen(file_content) < 2) {
-        return;
-    }
-    if (file_content[0] != '#' || file_content[1] != '!') {
-        return;
-    }
-    for (size_t i=0; i<strlen(file_content); i++) {
-        if (file_content[i] == '\n') {
-            break;
-        }
-        file_content[i] = ' ';
+// Size of the shebang line at the start of the file, which is skipped, or 0 if
+// there is none.
+static size_t shebang_size(const char* content, size_t size) {
+    if (size < 2 || content[0] != '#' || content[1] != '!') {
+        return 0;
     }
+    const char* line_end = memchr(content, '\n', size);
+    return line_end != NULL ? (size_t) (line_end - content) : size;
 }
 
 static void parse_a_file(sef_forth_state_t* fs, const char* file_name) {
-    FILE* f = fopen(file_name, "r");
-    if (f == NULL) {
+    int fd = open(file_name, O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0) {
         fprintf(stderr, "Can't open file %s.\n", file_name);
         exit(-1);
     }
-    // We allocate a buffer that can contain the whole file.
-    // We expect the dictionary growth to be proportional to the file size so
-    // it should be fine.
-    fseek(f, 0L, SEEK_END);
-    size_t file_size = ftell(f);
-    rewind(f);
-
-    char* content = malloc(file_size + 1);
-    if (content == NULL) {
-        fprintf(stderr, "Can't allocate bytes to read file.\n");
+    // The file is mapped and read in place instead of being copied, its pages
+    // being loaded as the parser reaches them.
+    size_t file_size = file_stat.st_size;
+    if (file_size == 0) {
+        close(fd);
+        return;
+    }
+    const char* content = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (content == MAP_FAILED) {
+        fprintf(stderr, "Can't map file %s.\n", file_name);
         exit(-1);
     }
-
-    fread(content, 1, file_size, f);
-    content[file_size] = 0;
-    clear_shebang_from_first_line(content);
-    sef_eval_string(fs, content);
-    free(content);
-    fclose(f);
+    size_t skipped = shebang_size(content, file_size);
+    sef_eval_buffer(fs, content + skipped, file_size - skipped);
+    munmap((void*) content, file_size);
 }
 
 static void repl(sef_forth_state_t* fs) {
@@ -52,9 +50,59 @@ static void repl(sef_forth_state_t* fs) {
     } while (!sef_asked_bye(fs)); // TODO: I wonder how I should leave the shell if bye is not there...
 }
 
-int main(int argc, char** argv) {
+#if SEF_SAMPLING_PROFILER
+#define SAMPLING_INTERVAL_US 1000
+#endif
+
+// With SEF_STACK_GUARD_PAGES, only the states made by `sef_create` have their
+// stacks between guard pages.
+static sef_forth_state_t* new_state(void) {
+#if SEF_STACK_GUARD_PAGES
+    sef_forth_state_t* fs = sef_create(NULL);
+    if (fs == NULL) {
+        fprintf(stderr, "Can't map the state.\n");
+        exit(-1);
+    }
+#else
     sef_forth_state_t* fs = malloc(sizeof(sef_forth_state_t));
     sef_init(fs);
+#endif
+    return fs;
+}
+
+int main(int argc, char** argv) {
+    sef_forth_state_t* fs = NULL;
+#if SEF_IMAGE
+    // With `--image <file>`, the state is loaded from an image written by
+    // `save-image` instead of compiling the system words.
+    if (argc > 2 && strcmp(argv[1], "--image") == 0) {
+        fs = malloc(sizeof(sef_forth_state_t));
+        if (!sef_load_image(fs, argv[2])) {
+            exit(-1);
+        }
+        argc -= 2;
+        argv += 2;
+    }
+#endif
+    bool created = fs == NULL;
+    if (created) {
+        fs = new_state();
+    }
+
+#if SEF_SAMPLING_PROFILER
+    // With `--profile <file>`, the whole run is sampled and written to the
+    // file as folded stacks.
+    const char* profile_path = NULL;
+    if (argc > 2 && strcmp(argv[1], "--profile") == 0) {
+        profile_path = argv[2];
+        argc -= 2;
+        argv += 2;
+        if (!sef_start_sampling(fs, SAMPLING_INTERVAL_US)) {
+            fprintf(stderr, "Can't start the sampling profiler.\n");
+            exit(-1);
+        }
+    }
+#endif
 
 #if SEF_ARG_AND_EXIT_CODE
     if (argc > 1) {
@@ -71,8 +119,22 @@ int main(int argc, char** argv) {
         repl(fs);
     }
 
+#if SEF_SAMPLING_PROFILER
+    if (profile_path != NULL && !sef_stop_sampling(fs, profile_path)) {
+        fprintf(stderr, "Can't write the profile to %s.\n", profile_path);
+    }
+#endif
+
     int exit_code = sef_exit_code(fs);
+#if SEF_STACK_GUARD_PAGES
+    if (created) {
+        sef_destroy(fs);
+    } else {
+        free(fs);
+    }
+#else
     free(fs);
+#endif
     return exit_code;
 }
 
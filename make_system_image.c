@@ -0,0 +1,40 @@
+#include "private_api.h"
+#include "stdio.h"
+
+// Compiles the system words and prints the dictionary made as the C array
+// restored by sef_state_init, see system_image.c in the Makefile. It must be
+// linked with the objects of libseforth and built with the same configuration.
+
+// This program makes the precompiled dictionary, so it can't use it.
+const sef_unsigned_t sef_system_image[1];
+const size_t sef_system_image_size = 0;
+
+#define CELLS_PER_LINE 4
+
+int main(void) {
+    forth_state_t* fs = malloc(DEFAULT_STATE_SIZE);
+    sef_state_set_regions(fs, NULL);
+    sef_compile_system_words(fs);
+    size_t size;
+    uint8_t* image = sef_image_encode(fs, &size);
+    if (image == NULL || !sef_ready_to_run((sef_forth_state_t*) fs)) {
+        fprintf(stderr, "Can't compile the system words.\n");
+        return 1;
+    }
+    const sef_unsigned_t* cells = (const sef_unsigned_t*) image;
+    size_t cell_count = size / sizeof(sef_unsigned_t);
+    printf("// Generated by make_system_image.bin, do not edit.\n");
+    printf("#include \"private_api.h\"\n\n");
+    printf("#if SEF_PRECOMPILED_DICTIONARY\n");
+    printf("const sef_unsigned_t sef_system_image[] = {");
+    for (size_t i=0; i<cell_count; i++) {
+        printf(i % CELLS_PER_LINE == 0 ? "\n   " : "");
+        printf(" 0x%llx,", (unsigned long long) cells[i]);
+    }
+    printf("\n};\n");
+    printf("const size_t sef_system_image_size = %zu;\n", size);
+    printf("#endif\n");
+    free(image);
+    free(fs);
+    return 0;
+}
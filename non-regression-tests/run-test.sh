@@ -36,6 +36,72 @@ compare_to_score () {
     fi
 }
 
+# Run the line of Forth code given as input from the prompt and check that it
+# is aborted with an out of bound data stack, before reaching the end of the
+# line. If it isn't, exit with an error.
+expect_data_stack_error () {
+    # The line is printed with the error, so "Failed!" is only printed whole
+    # if it runs.
+    out=$(printf '%s .( Fail) .( ed!)\n' "$1" | ../seforth.bin 2>&1)
+    if ! echo "$out" | grep "Stack 'data' out of bound" > /dev/null || echo "$out" | grep "Failed!" > /dev/null
+    then
+        echo "Error, '$1' didn't underflow the data stack!" > /dev/stderr
+        exit 1
+    fi
+}
+
+# Underflows of a single cell, which a guard page under the data stack can't
+# catch. Skipped if the stacks are not checked.
+if grep '#define SEF_STACK_BOUND_CHECKS 1' ../SEForth.h > /dev/null
+then
+    expect_data_stack_error ': x 1 2 rot 0 ; x . . .'
+    expect_data_stack_error 'drop 5 .'
+    expect_data_stack_error '1 + .'
+fi
+
+# Run the line of Forth code given as input from the prompt and check that it
+# reaches the end of the line. If it doesn't, exit with an error.
+expect_to_run () {
+    out=$(printf '%s .( Pass) .( ed!)\n' "$1" | ../seforth.bin 2>&1)
+    if ! echo "$out" | grep "Passed!" > /dev/null
+    then
+        echo "Error, '$1' didn't run to its end!" > /dev/stderr
+        exit 1
+    fi
+}
+
+# Words calling themselves are short enough to be inlined.
+expect_to_run ': foo recurse 1 ; : bar foo ;'
+expect_to_run ': foo 1 recurse ; : bar foo ;'
+
+# Run the line of Forth code given as input from the prompt, with the options
+# of seforth given after the expected output, and check that it prints that
+# output. If it doesn't, exit with an error.
+expect_output () {
+    line=$1
+    expected=$2
+    shift 2
+    out=$(printf '%s\n' "$line" | ../seforth.bin "$@" 2>&1)
+    if ! echo "$out" | grep -F -- "$expected" > /dev/null
+    then
+        echo "Error, '$line' didn't print '$expected'!" > /dev/stderr
+        exit 1
+    fi
+}
+
+# The run-time and the compile-time POSTPONE share their name, a state loaded
+# from an image, as the precompiled dictionary, must still tell them apart.
+expect_output ': x postpone dup ; immediate : y 3 x ; y . .' '3 3'
+# Same with an image saved by the user. Skipped if images are disabled.
+image=./postpone-test.img
+rm -f "$image"
+printf 's" %s" save-image\n' "$image" | ../seforth.bin > /dev/null 2>&1
+if [ -e "$image" ]
+then
+    expect_output ': x postpone dup ; immediate : y 3 x ; y . .' '3 3' --image "$image"
+    rm -f "$image"
+fi
+
 ok_std=$(count_ok "../seforth.bin ./standard-test.frt")
 
 compare_to_score "./score" "$ok_std"
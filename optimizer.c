@@ -0,0 +1,435 @@
+#include "private_api.h"
+
+/* ------------------------------ Instructions ------------------------------ */
+
+static sef_int_t opcode(dictionary_entry_t word) {
+    return *sef_get_entry_code_field(word);
+}
+
+static bool takes_operand(dictionary_entry_t word) {
+    switch (opcode(word)) {
+        case OP_LITERAL:
+        case OP_ZERO_BRANCH:
+        case OP_BRANCH:
+        case OP_OF:
+        case OP_QUESTION_DO:
+        case OP_DO:
+        case OP_PLUS_LOOP:
+        case OP_LOOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_superinstruction(dictionary_entry_t word) {
+    switch (opcode(word)) {
+        case OP_LITERAL_ADD:
+        case OP_DUP_ZERO_BRANCH:
+        case OP_EQ0_ZERO_BRANCH:
+        case OP_OVER_OVER:
+        case OP_R_FROM_DROP:
+        case OP_SWAP_DROP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* ---------------------------- Recording a body ---------------------------- */
+
+void sef_start_definition(forth_state_t* fs) {
+    fs->instructions_end = fs->here.cell;
+}
+
+void sef_record_instruction(forth_state_t* fs, sef_int_t* instruction) {
+    dictionary_entry_t word = (dictionary_entry_t) *instruction;
+    if (instruction != fs->instructions_end || is_superinstruction(word)) {
+        // Something else was compiled in between, the definition is left as is
+        fs->instructions_end = NULL;
+        return;
+    }
+    // The operand might be compiled later, as `LITERAL` does with `,`
+    fs->instructions_end = instruction + (takes_operand(word) ? 2 : 1);
+}
+
+void sef_replace_last_instruction(forth_state_t* fs, sef_int_t* instruction) {
+    if (fs->instructions_end != NULL) {
+        fs->instructions_end = instruction;
+        sef_record_instruction(fs, instruction);
+    }
+}
+
+bool sef_only_instructions_compiled(forth_state_t* fs) {
+    return fs->instructions_end == fs->here.cell;
+}
+
+#if SEF_OPTIMIZER
+/* ------------------------------ Simplifying ------------------------------- */
+
+// Number of cells taken by the C words that only compute a result from them,
+// which can be run at compile time. 0 for the other words.
+static size_t pure_operands(dictionary_entry_t word) {
+    switch (opcode(word)) {
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MULT:
+        case OP_LESS_THAN:
+        case OP_U_LESS_THAN:
+        case OP_EQ:
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR:
+        case OP_LSHIFT:
+        case OP_RSHIFT:
+#if SEF_NATIVE_CORE_WORDS
+        case OP_NOT_EQ:
+        case OP_GREATER_THAN:
+        case OP_MAX:
+        case OP_MIN:
+#endif
+            return 2;
+        case OP_LESS0:
+        case OP_EQ0:
+        case OP_TWO_SLASH:
+        case OP_CELLS:
+#if SEF_NATIVE_CORE_WORDS
+        case OP_ONE_PLUS:
+        case OP_ONE_MINUS:
+        case OP_NOT_EQ0:
+        case OP_GREATER0:
+        case OP_NEGATE:
+        case OP_INVERT:
+        case OP_CELL_PLUS:
+#endif
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Tells if calling the word does nothing, as for `: chars ;`.
+static bool is_empty_word(forth_state_t* fs, dictionary_entry_t word) {
+    if ((*sef_get_word_tag_field(word) & WORD_KIND) != WTM_FORTH_WORD) {
+        return false;
+    }
+    sef_int_t* body = sef_get_entry_parameter(word);
+    return *body == (sef_int_t) sef_get_word_from_cache(fs, EXIT);
+}
+
+struct instruction_s {
+    dictionary_entry_t word;
+    sef_int_t operand;
+    // Index of the last decoded instruction this one stands for.
+    size_t last_decoded;
+    // Set if a branch jumps right after this instruction.
+    bool target;
+    // Set if the operand is the address of a cell of the definition. The
+    // operand is then the index of the decoded instruction ending with that
+    // cell plus one, 0 being the start of the definition.
+    bool internal_target;
+};
+
+struct optimizer_s {
+    forth_state_t* fs;
+    struct instruction_s* decoded;
+    size_t decoded_count;
+    struct instruction_s* simplified;
+    size_t simplified_count;
+};
+
+// Replace the last instructions by a single one, which ends where they did.
+static void replace_last_instructions(struct optimizer_s* opt, size_t count, dictionary_entry_t word, sef_int_t operand) {
+    struct instruction_s last = opt->simplified[opt->simplified_count - 1];
+    opt->simplified_count -= count - 1;
+    struct instruction_s* replacement = &opt->simplified[opt->simplified_count - 1];
+    replacement->word = word;
+    replacement->operand = operand;
+    replacement->last_decoded = last.last_decoded;
+    replacement->target = last.target;
+    replacement->internal_target = false;
+}
+
+// Remove the last instructions. The branches jumping after them now jump after
+// the instruction before them.
+static void remove_last_instructions(struct optimizer_s* opt, size_t count) {
+    bool target = opt->simplified[opt->simplified_count - 1].target;
+    opt->simplified_count -= count;
+    if (target && opt->simplified_count > 0) {
+        opt->simplified[opt->simplified_count - 1].target = true;
+    }
+}
+
+// Tells if the count instructions before the last one are literals that no
+// branch jumps between.
+static bool literals_before_last(struct optimizer_s* opt, size_t count) {
+    if (opt->simplified_count <= count) {
+        return false;
+    }
+    for (size_t i=opt->simplified_count-1-count; i<opt->simplified_count-1; i++) {
+        if (opcode(opt->simplified[i].word) != OP_LITERAL || opt->simplified[i].target) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run a pure word on the literals before it, with the data stack.
+static sef_int_t evaluate_last_instruction(struct optimizer_s* opt, size_t operands) {
+    struct instruction_s* last = &opt->simplified[opt->simplified_count - 1];
+    for (size_t i=operands; i>0; i--) {
+        sef_push_data(opt->fs, last[-i].operand);
+    }
+    sef_exec_cfunc(opt->fs, sef_get_entry_parameter(last->word));
+    return sef_pop_data(opt->fs);
+}
+
+// Simplify the two last instructions when the first one is a literal. Return
+// true if it did.
+static bool simplify_literal_and_word(struct optimizer_s* opt) {
+    forth_state_t* fs = opt->fs;
+    sef_int_t value = opt->simplified[opt->simplified_count - 2].operand;
+    switch (opcode(opt->simplified[opt->simplified_count - 1].word)) {
+        case OP_DROP:
+            remove_last_instructions(opt, 2);
+            return true;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_OR:
+        case OP_XOR:
+        case OP_LSHIFT:
+        case OP_RSHIFT:
+            if (value == 0) {
+                remove_last_instructions(opt, 2);
+                return true;
+            }
+#if SEF_NATIVE_CORE_WORDS
+            if (value == 1 && opcode(opt->simplified[opt->simplified_count - 1].word) == OP_ADD) {
+                replace_last_instructions(opt, 2, sef_get_word_from_cache(fs, ONE_PLUS), 0);
+                return true;
+            }
+            if (value == 1 && opcode(opt->simplified[opt->simplified_count - 1].word) == OP_SUB) {
+                replace_last_instructions(opt, 2, sef_get_word_from_cache(fs, ONE_MINUS), 0);
+                return true;
+            }
+#endif
+            return false;
+        case OP_MULT:
+            if (value == 1) {
+                remove_last_instructions(opt, 2);
+                return true;
+            }
+            return false;
+        case OP_AND:
+            if (value == FORTH_TRUE) {
+                remove_last_instructions(opt, 2);
+                return true;
+            }
+            return false;
+        case OP_EQ:
+            if (value == 0) {
+                replace_last_instructions(opt, 2, sef_get_word_from_cache(fs, EQ0), 0);
+                return true;
+            }
+            return false;
+        case OP_LESS_THAN:
+            if (value == 0) {
+                replace_last_instructions(opt, 2, sef_get_word_from_cache(fs, LESS0), 0);
+                return true;
+            }
+            return false;
+#if SEF_NATIVE_CORE_WORDS
+        case OP_NOT_EQ:
+            if (value == 0) {
+                replace_last_instructions(opt, 2, sef_get_word_from_cache(fs, NOT_EQ0), 0);
+                return true;
+            }
+            return false;
+        case OP_GREATER_THAN:
+            if (value == 0) {
+                replace_last_instructions(opt, 2, sef_get_word_from_cache(fs, GREATER0), 0);
+                return true;
+            }
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+// Try to simplify the last instructions. Only the last one can be the target
+// of a branch. Return true if something was simplified.
+static bool simplify_last_instructions(struct optimizer_s* opt) {
+    if (opt->simplified_count == 0) {
+        return false;
+    }
+    dictionary_entry_t last = opt->simplified[opt->simplified_count - 1].word;
+    size_t operands = pure_operands(last);
+    if (operands != 0 && literals_before_last(opt, operands)) {
+        sef_int_t result = evaluate_last_instruction(opt, operands);
+        replace_last_instructions(opt, operands + 1, sef_get_word_from_cache(opt->fs, PAREN_LITERAL), result);
+        return true;
+    }
+    if (is_empty_word(opt->fs, last)) {
+        remove_last_instructions(opt, 1);
+        return true;
+    }
+
+    if (opt->simplified_count < 2 || opt->simplified[opt->simplified_count - 2].target) {
+        return false;
+    }
+    sef_int_t first = opcode(opt->simplified[opt->simplified_count - 2].word);
+    sef_int_t second = opcode(last);
+    if ((first == OP_SWAP && second == OP_SWAP) || (first == OP_DUP && second == OP_DROP)
+#if SEF_NATIVE_CORE_WORDS
+        || (first == OP_OVER && second == OP_DROP)
+#endif
+    ) {
+        remove_last_instructions(opt, 2);
+        return true;
+    }
+    if (first == OP_LITERAL) {
+        return simplify_literal_and_word(opt);
+    }
+    return false;
+}
+
+/* ------------------------- Decoding and rewriting ------------------------- */
+
+// Read the instructions from the body. Return false if a branch jumps to a
+// cell of the body that doesn't end an instruction.
+static bool decode_body(struct optimizer_s* opt, sef_int_t* body, size_t cells, size_t* decoded_ending_at) {
+    forth_state_t* fs = opt->fs;
+    for (size_t i=0; i<cells; i++) {
+        decoded_ending_at[i] = SIZE_MAX;
+    }
+    size_t cell = 0;
+    while (cell < cells) {
+        struct instruction_s* instruction = &opt->decoded[opt->decoded_count];
+        instruction->word = (dictionary_entry_t) body[cell];
+        // The other cells of a superinstruction are still there
+        instruction->word = sef_superinstruction_first_word(fs, instruction->word);
+        instruction->operand = 0;
+        instruction->last_decoded = opt->decoded_count;
+        instruction->target = false;
+        instruction->internal_target = false;
+        if (takes_operand(instruction->word)) {
+            cell++;
+            instruction->operand = body[cell];
+        }
+        decoded_ending_at[cell] = opt->decoded_count;
+        opt->decoded_count++;
+        cell++;
+    }
+
+    for (size_t i=0; i<opt->decoded_count; i++) {
+        struct instruction_s* instruction = &opt->decoded[i];
+        if (!takes_operand(instruction->word) || opcode(instruction->word) == OP_LITERAL) {
+            continue;
+        }
+        sef_int_t* target = (sef_int_t*) instruction->operand;
+        if (target < body - 1 || target >= body + cells) {
+            continue; // Tail call to another word
+        }
+        size_t target_index = 0;
+        if (target != body - 1) {
+            if (decoded_ending_at[target - body] == SIZE_MAX) {
+                return false;
+            }
+            target_index = decoded_ending_at[target - body] + 1;
+            opt->decoded[target_index - 1].target = true;
+        }
+        instruction->operand = target_index;
+        instruction->internal_target = true;
+    }
+    return true;
+}
+
+// Write the simplified instructions in place of the body and fix the targets of
+// the branches.
+static void rewrite_body(struct optimizer_s* opt, sef_int_t* body, sef_int_t** ends, sef_int_t** after_decoded) {
+    forth_state_t* fs = opt->fs;
+    fs->here.cell = body;
+    for (size_t i=0; i<opt->simplified_count; i++) {
+        struct instruction_s* instruction = &opt->simplified[i];
+        sef_int_t* start = fs->here.cell;
+        *fs->here.cell = (sef_int_t) instruction->word;
+        sef_allot_cell(fs);
+        if (takes_operand(instruction->word)) {
+            *fs->here.cell = instruction->operand;
+            sef_allot_cell(fs);
+        }
+        ends[i] = fs->here.cell - 1;
+        sef_compile_instruction(fs, start);
+    }
+
+    size_t simplified_index = 0;
+    after_decoded[0] = body - 1;
+    for (size_t i=0; i<opt->decoded_count; i++) {
+        after_decoded[i + 1] = after_decoded[i];
+        while (simplified_index < opt->simplified_count && opt->simplified[simplified_index].last_decoded <= i) {
+            after_decoded[i + 1] = ends[simplified_index];
+            simplified_index++;
+        }
+    }
+    for (size_t i=0; i<opt->simplified_count; i++) {
+        if (opt->simplified[i].internal_target) {
+            *ends[i] = (sef_int_t) after_decoded[opt->simplified[i].operand];
+        }
+    }
+    fs->instructions_end = fs->here.cell;
+}
+
+void sef_optimize_definition(forth_state_t* fs, dictionary_entry_t entry) {
+    sef_int_t* body = sef_get_entry_parameter(entry);
+    if (fs->instructions_end != fs->here.cell || body >= fs->here.cell) {
+        return;
+    }
+    size_t cells = fs->here.cell - body;
+
+    struct optimizer_s opt = {.fs = fs};
+    opt.decoded = malloc(cells * sizeof(struct instruction_s));
+    opt.simplified = malloc(cells * sizeof(struct instruction_s));
+    size_t* decoded_ending_at = malloc(cells * sizeof(size_t));
+    sef_int_t** ends = malloc(cells * sizeof(sef_int_t*));
+    sef_int_t** after_decoded = malloc((cells + 1) * sizeof(sef_int_t*));
+    if (opt.decoded == NULL || opt.simplified == NULL || decoded_ending_at == NULL || ends == NULL || after_decoded == NULL) {
+        goto end;
+    }
+    if (!decode_body(&opt, body, cells, decoded_ending_at)) {
+        debug_msg("%s has branches that can't be followed, it is not optimized.\n", sef_get_entry_name(entry));
+        goto end;
+    }
+
+    size_t simplified_cells = 0;
+    for (size_t i=0; i<opt.decoded_count; i++) {
+        opt.simplified[opt.simplified_count++] = opt.decoded[i];
+        while (simplify_last_instructions(&opt));
+    }
+    for (size_t i=0; i<opt.simplified_count; i++) {
+        simplified_cells += takes_operand(opt.simplified[i].word) ? 2 : 1;
+    }
+    if (simplified_cells < cells) {
+        rewrite_body(&opt, body, ends, after_decoded);
+        fs->optimized_cells += cells - simplified_cells;
+        debug_msg("Optimized %s from %zu to %zu cells.\n", sef_get_entry_name(entry), cells, simplified_cells);
+    }
+
+end:
+    free(opt.decoded);
+    free(opt.simplified);
+    free(decoded_ending_at);
+    free(ends);
+    free(after_decoded);
+}
+
+// optimized-cells
+void sef_optimized_cells(forth_state_t* fs) {
+    sef_push_data(fs, fs->optimized_cells);
+}
+#else
+void sef_optimize_definition(forth_state_t* fs, dictionary_entry_t entry) {
+    UNUSED(fs);
+    UNUSED(entry);
+}
+#endif
@@ -0,0 +1,37 @@
+#include "private_api.h"
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+// The instructions compiled in a definition are recorded, so that its body can
+// be read back by the optimizer and for inlining.
+
+// Start following the instructions of a new definition, whose body starts
+// HERE.
+void sef_start_definition(forth_state_t* fs);
+
+// Must be called after compiling an instruction, a word and the inline operand
+// it might take, that starts at the given address. Only the definitions made
+// entirely of such instructions can be read back, as the other cells might be
+// anything.
+void sef_record_instruction(forth_state_t* fs, sef_int_t* instruction);
+
+// Must be called when the last instruction recorded, which starts at the given
+// address, is replaced by another one, as done for tail calls.
+void sef_replace_last_instruction(forth_state_t* fs, sef_int_t* instruction);
+
+// Tells if the definition being compiled is only made of recorded
+// instructions up to HERE.
+bool sef_only_instructions_compiled(forth_state_t* fs);
+
+// Simplify the definition of the given entry, which must be the last one and
+// end HERE. Literal arithmetic is folded and sequences of words doing nothing
+// are removed. HERE is moved back by the number of cells saved.
+void sef_optimize_definition(forth_state_t* fs, dictionary_entry_t entry);
+
+#if SEF_OPTIMIZER
+// Push the number of cells saved by the optimizer since the start.
+void sef_optimized_cells(forth_state_t* fs);
+#endif
+
+#endif
+
@@ -13,11 +13,26 @@ void sef_exec_forth_word(forth_state_t* fs, void* parameter) {
 
 static void inter_compil_entry(forth_state_t* fs, dictionary_entry_t entry);
 static void inter_compil_number(forth_state_t* fs, sef_int_t number);
+static void forget_tail_call_candidate(forth_state_t* fs);
 
 static void add_word_from_cache(forth_state_t* fs, enum word_in_cache word) {
     inter_compil_entry(fs, sef_get_word_from_cache(fs, word));
 }
 
+// Compile a word from the cache followed by an inline operand, such as
+// (literal) or the branches. Return the address of the operand.
+static sef_int_t* add_word_with_operand(forth_state_t* fs, enum word_in_cache word, sef_int_t operand) {
+    forget_tail_call_candidate(fs);
+    sef_int_t* instruction = fs->here.cell;
+    *fs->here.cell = (sef_int_t) sef_get_word_from_cache(fs, word);
+    sef_allot_cell(fs);
+    *fs->here.cell = operand;
+    sef_allot_cell(fs);
+    sef_record_instruction(fs, instruction);
+    sef_compile_instruction(fs, instruction);
+    return instruction + 1;
+}
+
 /* ------------------------- Input source management ------------------------ */
 
 #define CELL_USED_FOR_INPUT_SOURCE 6
@@ -65,34 +80,36 @@ static void refill(forth_state_t* fs) {
     sef_push_data(fs, FORTH_BOOL(refill_rc));
 }
 
-/* -------------------------- C string input source ------------------------- */
+/* -------------------------- C buffer input source ------------------------- */
 
-static bool c_string_refill(forth_state_t* fs, void* input_source) {
-    char* left_to_fill = ((char*) input_source) + fs->input_buffer_size;
-    size_t chars_left = strlen(left_to_fill);
-    if (chars_left == 0) {
-        return false;
+// The input source is the text from `fs->input_source` to
+// `fs->input_source_end`, read a line at a time. The end of each line is found
+// with memchr, so reading the whole text takes a time linear in its size.
+static bool c_buffer_refill(forth_state_t* fs, void* input_source) {
+    const char* next_line = ((const char*) input_source) + fs->input_buffer_size;
+    const char* end = fs->input_source_end;
+    while (next_line < end && *next_line == '\n') {
+        next_line++;
     }
-    while (*left_to_fill == '\n') {
-        left_to_fill++;
+    if (next_line == end) {
+        return false;
     }
-    fs->input_buffer = left_to_fill;
-    fs->input_source = left_to_fill;
-    fs->input_buffer_size = 0;
-    for (size_t i=0; i<strlen(fs->input_buffer); i++) {
-        if (fs->input_buffer[i] == '\n') {
-            break;
-        }
-        fs->input_buffer_size++;
+    const char* line_end = memchr(next_line, '\n', end - next_line);
+    if (line_end == NULL) {
+        line_end = end;
     }
+    fs->input_buffer = (char*) next_line; // The input buffer is never written to.
+    fs->input_source = (char*) next_line;
+    fs->input_buffer_size = line_end - next_line;
     return true;
 }
 
-void sef_set_c_string_as_input_source(forth_state_t* fs, const char* str) {
-    fs->input_source = (char*) str; // I won't edit it with c_string refill, so no biggie with const.
+void sef_set_c_buffer_as_input_source(forth_state_t* fs, const char* buffer, size_t size) {
+    fs->input_source = (char*) buffer;
+    fs->input_source_end = buffer + size;
     fs->input_buffer_size = 0;
     fs->parse_area_offset = 0;
-    fs->input_source_refill = c_string_refill;
+    fs->input_source_refill = c_buffer_refill;
     fs->source_id = 0;
 }
 
@@ -218,6 +235,11 @@ static void new_forth_word(forth_state_t* fs, const char* name, size_t name_len)
     sef_push_data(fs, COLON_SYS_MAGIC);
     enter_compilation(fs);
     sef_register_new_word(fs, name, name_len, WTM_FORTH_WORD);
+    fs->tail_call_candidate = NULL;
+    fs->branches_after_tail_call_candidate = NULL;
+    fs->recursive_tail_calls = NULL;
+    fs->return_stack_balance = 0;
+    sef_start_definition(fs);
     if (sef_get_entry_parameter(fs->last_dictionary_entry) != fs->here.cell) {
         SEF_ERROR_OUT(fs, "Memory error, %p should be %p.\n",
                       sef_get_entry_parameter(fs->last_dictionary_entry),
@@ -239,13 +261,27 @@ static void no_name(forth_state_t* fs) {
     sef_push_data(fs, magic);
 }
 
+static void resolve_recursive_tail_calls(forth_state_t* fs);
+#if SEF_INLINE_MAX_CELLS
+static void mark_inlinable(forth_state_t* fs, dictionary_entry_t entry);
+#endif
+
 static void semicolon(forth_state_t* fs) {
     add_word_from_cache(fs, EXIT);
+    resolve_recursive_tail_calls(fs);
     leave_compilation(fs);
     sef_int_t magic = sef_pop_data(fs);
     if (magic != COLON_SYS_MAGIC) {
         SEF_ERROR_OUT(fs, "Imbalanced stack when compiling \"%s\".\n", sef_get_entry_name(fs->last_dictionary_entry));
+        return;
     }
+    sef_optimize_definition(fs, fs->last_dictionary_entry);
+#if SEF_INLINE_MAX_CELLS
+    mark_inlinable(fs, fs->last_dictionary_entry);
+#endif
+#if SEF_JIT_ENABLED
+    sef_jit_compile(fs, fs->last_dictionary_entry, fs->here.cell);
+#endif
 }
 
 static void immediate(forth_state_t* fs) {
@@ -253,10 +289,16 @@ static void immediate(forth_state_t* fs) {
     *tag_field |= WTM_IMMEDIATE;
 }
 
+static void noinline(forth_state_t* fs) {
+    sef_int_t* tag_field = sef_get_word_tag_field(fs->last_dictionary_entry);
+    *tag_field &= ~WTM_INLINE;
+}
+
 static void does(forth_state_t* fs) {
     sef_int_t* tag_field = sef_get_word_tag_field(fs->last_dictionary_entry);
     *tag_field &= ~WORD_KIND;
     *tag_field |= WTM_DOES_EXECUTION;
+    *sef_get_entry_code_field(fs->last_dictionary_entry) = OP_DODOES;
     sef_int_t* special_parameters = sef_get_entry_special_parameters(fs->last_dictionary_entry);
     *special_parameters = (sef_int_t) (fs->code_pointer);
     sef_exit(fs); // We don't want to execute what is made for the other word.
@@ -268,7 +310,7 @@ void sef_exec_create(forth_state_t* fs, void* parameter) {
     sef_push_data(fs, (sef_int_t) parameter);
 }
 
-void sef_create(forth_state_t* fs, const char* name, size_t name_len) {
+void sef_create_entry(forth_state_t* fs, const char* name, size_t name_len) {
     sef_register_new_word(fs, name, name_len, WTM_CREATE);
 }
 
@@ -276,107 +318,114 @@ static void create(forth_state_t* fs) {
     parse_name(fs);
     size_t name_len = (size_t) sef_pop_data(fs);
     char* name = (char*) sef_pop_data(fs);
-    sef_create(fs, name, name_len);
+    sef_create_entry(fs, name, name_len);
 }
 
 /* --------------------------- Control-flow words --------------------------- */
 
 // TODO: Maybe add a check that we are in a word definition for all those words.
 
+// The branches read the address to jump to from the cell after them. As the
+// code pointer is moved to the next cell after each word, that address is the
+// one of the cell before the first word to execute. When the target is not
+// known yet, the address of the operand is put on the control-flow stack to be
+// filled in later.
+
 static void if_compile_time(forth_state_t* fs) {
-    // We start by adding an empty number, it will be edited by else or then.
-    inter_compil_number(fs, 0);
-    // We push the address of the number to fill in in the control flow stack.
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
-    // Then we add the runtime word
-    add_word_from_cache(fs, IF);
+    sef_int_t* empty_cell = add_word_with_operand(fs, ZERO_BRANCH, 0);
+    sef_push_control_flow(fs, (sef_int_t) empty_cell);
 }
 
 static void else_compile_time(forth_state_t* fs) {
     // Pop the address of the if-targeted address.
     sef_int_t* empty_cell = (sef_int_t*) sef_pop_control_flow(fs);
-    // Add an empty number to the control flow stack to target THEN
-    inter_compil_number(fs, 0);
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
-    // Fill in the empty address with where we are putting (else)
-    *empty_cell = (sef_int_t) fs->here.cell;
+    // Add a branch whose target will be filled in by THEN
+    sef_int_t* else_empty_cell = add_word_with_operand(fs, BRANCH, 0);
+    sef_push_control_flow(fs, (sef_int_t) else_empty_cell);
+    // (0branch) continues after the branch
+    *empty_cell = (sef_int_t) else_empty_cell;
     debug_msg("Else wrote in if the value 0x%lX.\n", (long) *empty_cell);
-    add_word_from_cache(fs, ELSE);
 }
 
 static void then(forth_state_t* fs) {
     // For THEN, we don't need to put in a word, as then does nothing.
-    // We only need to fill-in the address for if or else.
-    // But we need to decrease it by one so that the end-of-execution for
-    // (if) or (else) make it point to the correct sub-word.
+    // We only need to fill-in the address for if or else, which is the
+    // address of the last cell compiled.
     sef_int_t* empty_cell = (sef_int_t*) sef_pop_control_flow(fs);
+    if (fs->tail_call_candidate != NULL && fs->tail_call_candidate == fs->here.cell - 1) {
+        // That address moves if the call becomes a tail call, so the branches
+        // to it are linked together until then.
+        *empty_cell = (sef_int_t) fs->branches_after_tail_call_candidate;
+        fs->branches_after_tail_call_candidate = empty_cell;
+        return;
+    }
     *empty_cell = (sef_int_t) (fs->here.cell - 1);
     debug_msg("Then wrote in if the value 0x%lX.\n", (long) *empty_cell);
 }
 
 static void begin(forth_state_t* fs) {
-    // Begin does nothing when executing so we to push the address of HERE which
-    // will be used by WHILE and REPEAT
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1)); // -1 as there won't be a runtime begin
+    // Begin does nothing when executing so we to push the address of the last
+    // cell compiled, which will be the target of the branches going back to it
+    forget_tail_call_candidate(fs);
+    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
 }
 
 static void while_compile_time(forth_state_t* fs) {
     sef_int_t begin_address = sef_pop_control_flow(fs);
     // While needs a black address that will be filled-in by repeat
-    inter_compil_number(fs, 0);
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
+    sef_int_t* empty_cell = add_word_with_operand(fs, ZERO_BRANCH, 0);
+    sef_push_control_flow(fs, (sef_int_t) empty_cell);
     sef_push_control_flow(fs, begin_address);
-    add_word_from_cache(fs, WHILE);
 }
 
 static void repeat_compile_time(forth_state_t* fs) {
     sef_int_t begin_address = sef_pop_control_flow(fs);
     sef_int_t* while_empty_cell = (sef_int_t*) sef_pop_control_flow(fs);
+    // Going back to begin
+    sef_int_t* branch_operand = add_word_with_operand(fs, BRANCH, begin_address);
+    // Filling in the blank word from while to continue after the branch
+    *while_empty_cell = (sef_int_t) branch_operand;
+}
+
+static void until(forth_state_t* fs) {
+    sef_int_t begin_address = sef_pop_control_flow(fs);
+    add_word_with_operand(fs, ZERO_BRANCH, begin_address);
+}
 
-    // Putting the address of begin as a literal, the runtime repeat will go to it.
-    inter_compil_number(fs, begin_address);
-    // Filling in the blank word from while with repeat address
-    *while_empty_cell = (sef_int_t) (fs->here.cell);
-    add_word_from_cache(fs, REPEAT);
+static void again(forth_state_t* fs) {
+    sef_int_t begin_address = sef_pop_control_flow(fs);
+    add_word_with_operand(fs, BRANCH, begin_address);
+}
 
+// The runtime words of do loops take the address of the other end of the loop
+// in the cell after them. The loop-sys, left on the return stack at runtime, is
+// ( LOOP address, end value, current value ).
+static void any_do_compile_time(forth_state_t* fs, enum word_in_cache word) {
+    // Address of the closing +loop filled by it, to bail out there if needed
+    sef_int_t* empty_cell = add_word_with_operand(fs, word, 0);
+    sef_push_control_flow(fs, (sef_int_t) empty_cell);
 }
 
-// For do loop, the loop-sys will be ( LOOP address, end value, current value )
 static void question_do_compile_time(forth_state_t* fs) {
-    // Getting address of the closing +loop to bail out there if needed
-    inter_compil_number(fs, 0);
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
-    add_word_from_cache(fs, QUESTION_DO);
+    any_do_compile_time(fs, QUESTION_DO);
 }
 
 static void do_compile_time(forth_state_t* fs) {
-    inter_compil_number(fs, 0);
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
-    add_word_from_cache(fs, DO);
+    any_do_compile_time(fs, DO);
 }
 
-static void any_loop_compile_time(forth_state_t* fs) {
-    sef_int_t* end_of_loop_pointer = (sef_int_t*) sef_pop_control_flow(fs);
-    sef_int_t* question_do_address = end_of_loop_pointer + 1;
-    inter_compil_number(fs, (sef_int_t) question_do_address);
-    *end_of_loop_pointer = (sef_int_t) fs->here.cell;
+static void any_loop_compile_time(forth_state_t* fs, enum word_in_cache word) {
+    sef_int_t* do_pointer = (sef_int_t*) sef_pop_control_flow(fs);
+    sef_int_t* loop_pointer = add_word_with_operand(fs, word, (sef_int_t) do_pointer);
+    *do_pointer = (sef_int_t) loop_pointer;
 }
 
 static void plus_loop_compile_time(forth_state_t* fs) {
-    any_loop_compile_time(fs);
-    add_word_from_cache(fs, PLUS_LOOP);
+    any_loop_compile_time(fs, PLUS_LOOP);
 }
 
 static void loop_compile_time(forth_state_t* fs) {
-    any_loop_compile_time(fs);
-    add_word_from_cache(fs, LOOP);
-}
-
-static void leave(forth_state_t* fs) {
-    sef_pop_return(fs);
-    sef_pop_return(fs);
-    dictionary_entry_t end_off_loop = (dictionary_entry_t) sef_pop_return(fs);
-    fs->code_pointer = end_off_loop;
+    any_loop_compile_time(fs, LOOP);
 }
 
 static void case_compile_time(forth_state_t* fs) {
@@ -386,22 +435,19 @@ static void case_compile_time(forth_state_t* fs) {
 }
 
 static void of_compile_time(forth_state_t* fs) {
-    inter_compil_number(fs, 0);
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
-    add_word_from_cache(fs, OF);
+    sef_int_t* empty_cell = add_word_with_operand(fs, PAREN_OF, 0);
+    sef_push_control_flow(fs, (sef_int_t) empty_cell);
 }
 
 static void endof_compile_time(forth_state_t* fs) {
     sef_int_t* of_pointer = (sef_int_t*) sef_pop_control_flow(fs);
     sef_int_t number_of_cases = sef_pop_control_flow(fs);
-    // Putting the address of endcase as a literal and putting it on the stack
-    inter_compil_number(fs, 0);
-    sef_push_control_flow(fs, (sef_int_t) (fs->here.cell - 1));
+    // Branch to endcase, filled in by endcase
+    sef_int_t* empty_cell = add_word_with_operand(fs, BRANCH, 0);
+    sef_push_control_flow(fs, (sef_int_t) empty_cell);
     sef_push_control_flow(fs, number_of_cases+1);
-    // Runtime effect
-    add_word_from_cache(fs, ENDOF);
-    // Filling in the address for the of word
-    *of_pointer = (sef_int_t) (fs->here.cell - 1);
+    // (of) continues after the branch
+    *of_pointer = (sef_int_t) empty_cell;
 }
 
 static void endcase(forth_state_t* fs) {
@@ -411,7 +457,8 @@ static void endcase(forth_state_t* fs) {
         sef_int_t** endcase_pointer = (sef_int_t**) sef_pop_control_flow(fs);
         *endcase_pointer = fs->here.cell;
     }
-    // The runtime is the same as drop
+    // The runtime is the same as drop. The branches of the endofs jump over
+    // it, as the matching of consumed the selector.
     add_word_from_cache(fs, DROP);
 }
 
@@ -473,6 +520,289 @@ static void postpone_compile_time(forth_state_t* fs) {
     }
 }
 
+static void compile_comma(forth_state_t* fs) {
+    dictionary_entry_t entry = (dictionary_entry_t) sef_pop_data(fs);
+    sef_compile_entry(fs, entry);
+}
+
+/* ------------------------------- Tail calls ------------------------------- */
+
+// A call to a Forth word followed by EXIT is compiled as a branch to the start
+// of the word, which then returns directly to our caller. This is only done
+// when the word called doesn't read the return stack beyond the cells it
+// pushed itself, as it would see our return address instead of its own.
+
+static sef_int_t get_return_stack_reach(dictionary_entry_t entry) {
+    return (*sef_get_word_tag_field(entry) & WTM_RETURN_STACK_REACH) >> RETURN_STACK_REACH_SHIFT;
+}
+
+static void raise_return_stack_reach(forth_state_t* fs, sef_int_t reach) {
+    if (reach > MAX_RETURN_STACK_REACH) {
+        reach = MAX_RETURN_STACK_REACH;
+    }
+    if (reach > get_return_stack_reach(fs->last_dictionary_entry)) {
+        sef_int_t* tag_field = sef_get_word_tag_field(fs->last_dictionary_entry);
+        *tag_field &= ~WTM_RETURN_STACK_REACH;
+        *tag_field |= reach << RETURN_STACK_REACH_SHIFT;
+    }
+}
+
+// Follow the cells the word being compiled pushes on and pops from the return
+// stack to compute its reach. Control flow is ignored, which might only
+// overestimate the reach.
+static void track_return_stack(forth_state_t* fs, dictionary_entry_t entry) {
+    if (entry == sef_get_word_from_cache(fs, TO_R)) {
+        fs->return_stack_balance++;
+    } else if (entry == sef_get_word_from_cache(fs, R_FROM)) {
+        fs->return_stack_balance--;
+        raise_return_stack_reach(fs, -fs->return_stack_balance);
+    } else {
+        // The word called reads our return address first
+        sef_int_t reach = get_return_stack_reach(entry);
+        if (reach == MAX_RETURN_STACK_REACH) {
+            raise_return_stack_reach(fs, MAX_RETURN_STACK_REACH);
+        } else {
+            raise_return_stack_reach(fs, reach - 1 - fs->return_stack_balance);
+        }
+    }
+}
+
+static bool can_tail_call(dictionary_entry_t entry) {
+    sef_int_t opcode = *sef_get_entry_code_field(entry);
+#if SEF_JIT_ENABLED
+    if (opcode == OP_DONATIVE) {
+        opcode = OP_DOCOL;
+    }
+#endif
+    return opcode == OP_DOCOL && get_return_stack_reach(entry) == 0;
+}
+
+// Set the branches linked by THEN to the given target.
+static void resolve_branches_after_tail_call_candidate(forth_state_t* fs, sef_int_t* target) {
+    sef_int_t* branch_operand = fs->branches_after_tail_call_candidate;
+    while (branch_operand != NULL) {
+        sef_int_t* next = (sef_int_t*) *branch_operand;
+        *branch_operand = (sef_int_t) target;
+        branch_operand = next;
+    }
+    fs->branches_after_tail_call_candidate = NULL;
+}
+
+// Called when something else than EXIT is compiled after the last call.
+static void forget_tail_call_candidate(forth_state_t* fs) {
+    resolve_branches_after_tail_call_candidate(fs, fs->tail_call_candidate);
+    fs->tail_call_candidate = NULL;
+}
+
+#if SEF_TAIL_CALLS
+// Called when compiling EXIT in the given cell. If it follows a call that can
+// be made a tail call, replace both by a branch to the word called and return
+// true. An EXIT is kept after it if some branches jumped after the call.
+static bool compile_tail_call(forth_state_t* fs, sef_int_t* exit_cell) {
+    sef_int_t* call = fs->tail_call_candidate;
+    if (call == NULL || call + 1 != exit_cell) {
+        return false;
+    }
+    dictionary_entry_t entry = (dictionary_entry_t) *call;
+    *call = (sef_int_t) sef_get_word_from_cache(fs, BRANCH);
+    sef_replace_last_instruction(fs, call);
+    if (entry == fs->last_dictionary_entry) {
+        // The reach of the word being compiled is only known once it is
+        // finished. Until then, the recursive tail calls are linked together
+        // through their operands.
+        *exit_cell = (sef_int_t) fs->recursive_tail_calls;
+        fs->recursive_tail_calls = exit_cell;
+    } else {
+        *exit_cell = (sef_int_t) ((sef_int_t*) sef_get_entry_parameter(entry) - 1);
+    }
+    sef_allot_cell(fs);
+    fs->tail_call_candidate = NULL;
+    if (fs->branches_after_tail_call_candidate != NULL) {
+        resolve_branches_after_tail_call_candidate(fs, exit_cell);
+        *fs->here.cell = (sef_int_t) sef_get_word_from_cache(fs, EXIT);
+        sef_allot_cell(fs);
+        sef_record_instruction(fs, fs->here.cell - 1);
+    }
+    return true;
+}
+#endif
+
+// Point the recursive tail calls to the start of the word just compiled, or
+// turn them back into a call followed by EXIT if the word reads the return
+// stack.
+static void resolve_recursive_tail_calls(forth_state_t* fs) {
+    dictionary_entry_t entry = fs->last_dictionary_entry;
+    sef_int_t* operand = fs->recursive_tail_calls;
+    while (operand != NULL) {
+        sef_int_t* next = (sef_int_t*) *operand;
+        if (can_tail_call(entry)) {
+            *operand = (sef_int_t) ((sef_int_t*) sef_get_entry_parameter(entry) - 1);
+        } else {
+            operand[-1] = (sef_int_t) entry;
+            *operand = (sef_int_t) sef_get_word_from_cache(fs, EXIT);
+        }
+        operand = next;
+    }
+    fs->recursive_tail_calls = NULL;
+}
+
+/* -------------------------------- Inlining -------------------------------- */
+
+// A call to a short colon definition is replaced by a copy of its body. As the
+// body is copied, redefining the word later doesn't change the words it was
+// inlined in, as with any other redefinition.
+
+static void compile_entry(forth_state_t* fs, dictionary_entry_t entry, bool can_inline);
+
+#if SEF_INLINE_MAX_CELLS
+struct inlined_instruction_s {
+    dictionary_entry_t word;
+    sef_int_t operand;
+};
+
+// Words called from the inlined body get the address of a cell of our caller
+// as return address, they must not read it. The code pointer read by the body
+// would be the one of our caller as well.
+static bool can_call_from_anywhere(forth_state_t* fs, dictionary_entry_t entry) {
+    sef_int_t tags = *sef_get_word_tag_field(entry);
+    switch (tags & WORD_KIND) {
+        case WTM_C_WORD:
+            return entry != sef_get_word_from_cache(fs, DOES) && entry != sef_get_word_from_cache(fs, CODE_POINTER);
+        case WTM_FORTH_WORD:
+            return get_return_stack_reach(entry) == 0;
+        case WTM_DOES_EXECUTION: {
+            void* does_code = (void*) *sef_get_entry_special_parameters(entry);
+            dictionary_entry_t defining_word = sef_try_to_find_entry(fs, does_code);
+            return defining_word != NULL && get_return_stack_reach(defining_word) == 0;
+        }
+        default:
+            return true;
+    }
+}
+
+// Read the body of a word that can be inlined. Return the number of
+// instructions read, or -1 if the word can't be inlined. It must have at most
+// SEF_INLINE_MAX_CELLS cells before its EXIT, made of literals and words that
+// don't use the return stack or the code pointer. A body calling the word
+// itself, compiled by RECURSE, would be inlined forever.
+static int read_inlinable_body(forth_state_t* fs, dictionary_entry_t entry, struct inlined_instruction_s* instructions) {
+    sef_int_t* cell = sef_get_entry_parameter(entry);
+    int cells = 0;
+    for (int count=0; ; count++) {
+        dictionary_entry_t word = sef_superinstruction_first_word(fs, (dictionary_entry_t) *cell);
+        sef_int_t opcode = *sef_get_entry_code_field(word);
+        if (opcode == OP_EXIT) {
+            return count;
+        }
+        cells += opcode == OP_LITERAL ? 2 : 1;
+        if (cells > SEF_INLINE_MAX_CELLS) {
+            return -1;
+        }
+        if (word == entry) {
+            return -1;
+        }
+        instructions[count].word = word;
+        switch (opcode) {
+            case OP_LITERAL:
+                instructions[count].operand = cell[1];
+                cell += 2;
+                break;
+            case OP_BRANCH:
+                // A tail call, to the cell before the body of the word called.
+                // A branch back in the body is a loop.
+                if ((sef_int_t*) cell[1] < cell && (sef_int_t*) cell[1] >= (sef_int_t*) sef_get_entry_parameter(entry) - 1) {
+                    return -1;
+                }
+                instructions[count].word = (dictionary_entry_t) cell[1] - 2;
+                if ((*sef_get_word_tag_field(instructions[count].word) & WORD_KIND) != WTM_FORTH_WORD || !can_call_from_anywhere(fs, instructions[count].word)) {
+                    return -1;
+                }
+                return count + 1;
+            case OP_ZERO_BRANCH:
+            case OP_QUESTION_DO:
+            case OP_DO:
+            case OP_PLUS_LOOP:
+            case OP_LOOP:
+            case OP_I:
+            case OP_J:
+            case OP_UNLOOP:
+            case OP_LEAVE:
+            case OP_OF:
+            case OP_TO_R:
+            case OP_R_FROM:
+                return -1;
+            default:
+                if (!can_call_from_anywhere(fs, word)) {
+                    return -1;
+                }
+                cell++;
+        }
+    }
+}
+
+// Called when a definition is finished. Tag it with WTM_INLINE if it can be
+// inlined. Its body can only be read if nothing else than instructions was
+// compiled in it.
+static void mark_inlinable(forth_state_t* fs, dictionary_entry_t entry) {
+    struct inlined_instruction_s instructions[SEF_INLINE_MAX_CELLS];
+    if (sef_only_instructions_compiled(fs) && read_inlinable_body(fs, entry, instructions) >= 0) {
+        *sef_get_word_tag_field(entry) |= WTM_INLINE;
+    }
+}
+
+// Compile the body of the given word if it can be inlined. Return true if it
+// did. The words of the body were already inlined when it was compiled, so
+// they are not inlined again, which also bounds the recursion.
+static bool compile_inline(forth_state_t* fs, dictionary_entry_t entry) {
+    if (!(*sef_get_word_tag_field(entry) & WTM_INLINE)) {
+        return false;
+    }
+    struct inlined_instruction_s instructions[SEF_INLINE_MAX_CELLS];
+    int count = read_inlinable_body(fs, entry, instructions);
+    debug_msg("Inlining %s.\n", sef_get_entry_name(entry));
+    for (int i=0; i<count; i++) {
+        if (*sef_get_entry_code_field(instructions[i].word) == OP_LITERAL) {
+            add_word_with_operand(fs, PAREN_LITERAL, instructions[i].operand);
+        } else {
+            compile_entry(fs, instructions[i].word, false);
+        }
+    }
+    return true;
+}
+#endif
+
+static void compile_entry(forth_state_t* fs, dictionary_entry_t entry, bool can_inline) {
+    sef_int_t* instruction = fs->here.cell;
+    if (!fs->compiling) {
+        *fs->here.cell = (sef_int_t) entry;
+        sef_allot_cell(fs);
+        return;
+    }
+#if SEF_TAIL_CALLS
+    if (entry == sef_get_word_from_cache(fs, EXIT) && compile_tail_call(fs, instruction)) {
+        return;
+    }
+#endif
+#if SEF_INLINE_MAX_CELLS
+    if (can_inline && compile_inline(fs, entry)) {
+        return;
+    }
+#else
+    UNUSED(can_inline);
+#endif
+    forget_tail_call_candidate(fs);
+    *fs->here.cell = (sef_int_t) entry;
+    sef_allot_cell(fs);
+    track_return_stack(fs, entry);
+    sef_record_instruction(fs, instruction);
+    bool fused = sef_compile_instruction(fs, instruction);
+    fs->tail_call_candidate = (SEF_TAIL_CALLS && !fused && can_tail_call(entry)) ? instruction : NULL;
+}
+
+void sef_compile_entry(forth_state_t* fs, dictionary_entry_t entry) {
+    compile_entry(fs, entry, true);
+}
+
 /* ---------------------- Exporting compile time words ---------------------- */
 
 struct c_func_s {
@@ -493,6 +823,7 @@ struct c_func_s all_default_parser_c_func[] = {
     {";", semicolon, true},
     {":noname", no_name, false},
     {"immediate", immediate, false},
+    {"noinline", noinline, false},
     {"does>", does, false},
     {"create", create, false},
 
@@ -502,11 +833,12 @@ struct c_func_s all_default_parser_c_func[] = {
     {"begin", begin, true},
     {"while", while_compile_time, true},
     {"repeat", repeat_compile_time, true},
+    {"until", until, true},
+    {"again", again, true},
     {"do", do_compile_time, true},
     {"?do", question_do_compile_time, true},
     {"+loop", plus_loop_compile_time, true},
     {"loop", loop_compile_time, true},
-    {"leave", leave, false},
     {"case", case_compile_time, true},
     {"of", of_compile_time, true},
     {"endof", endof_compile_time, true},
@@ -517,6 +849,7 @@ struct c_func_s all_default_parser_c_func[] = {
     {"restore-input", sef_pop_input_source, false},
 
     {"postpone", postpone_compile_time, true},
+    {"compile,", compile_comma, false},
 };
 
 void sef_register_parser_cfunc(forth_state_t* fs) {
@@ -526,6 +859,14 @@ void sef_register_parser_cfunc(forth_state_t* fs) {
     }
 }
 
+const char* sef_parser_cfunc_at(size_t index, cfunc* func) {
+    if (index >= sizeof(all_default_parser_c_func) / sizeof(struct c_func_s)) {
+        return NULL;
+    }
+    *func = all_default_parser_c_func[index].func;
+    return all_default_parser_c_func[index].name;
+}
+
 /* ------------------------ Compile/Interpret routine ----------------------- */
 
 // Handle compilation of interpretation of a word found in the dictionary.
@@ -536,17 +877,14 @@ static void inter_compil_entry(forth_state_t* fs, dictionary_entry_t entry) {
         sef_call_entry(fs, entry);
         sef_run(fs);
     } else {
-        *fs->here.cell = (sef_int_t) entry;
-        sef_allot_cell(fs);
+        sef_compile_entry(fs, entry);
     }
 }
 
 // Handle compilation of interpretation of a number.
 static void inter_compil_number(forth_state_t* fs, sef_int_t number) {
     if (fs->compiling) {
-        add_word_from_cache(fs, PAREN_LITERAL);
-        *fs->here.cell = number;
-        sef_allot_cell(fs);
+        add_word_with_operand(fs, PAREN_LITERAL, number);
     } else {
         sef_push_data(fs, number);
     }
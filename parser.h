@@ -9,12 +9,20 @@ void sef_inter_compil_run(forth_state_t* fs);
 // Register parser's compile time words writtens in C.
 void sef_register_parser_cfunc(forth_state_t* fs);
 
-// Set a C string as the input source.
-void sef_set_c_string_as_input_source(forth_state_t* fs, const char* str);
+// Return the name of the parser's word at the given index of its table and set
+// `func` to its function, or return NULL past the end of the table.
+const char* sef_parser_cfunc_at(size_t index, cfunc* func);
+
+// Set the `size` chars of `buffer` as the input source. They don't need to be
+// null-terminated.
+void sef_set_c_buffer_as_input_source(forth_state_t* fs, const char* buffer, size_t size);
 
 // Reset the input source as before the last set.
 void sef_pop_input_source(forth_state_t* fs);
 
+// Compile a call to an entry HERE.
+void sef_compile_entry(forth_state_t* fs, dictionary_entry_t entry);
+
 // Execute a Forth word
 void sef_exec_forth_word(forth_state_t* fs, void* parameter);
 
@@ -22,7 +30,7 @@ void sef_exec_forth_word(forth_state_t* fs, void* parameter);
 void sef_exec_create(forth_state_t* fs, void* parameter);
 
 // Register a new create word
-void sef_create(forth_state_t* fs, const char* name, size_t name_len);
+void sef_create_entry(forth_state_t* fs, const char* name, size_t name_len);
 
 #endif
 
@@ -16,6 +16,10 @@ typedef struct forth_state_s forth_state_t;
 typedef sef_int_t* dictionary_entry_t;
 
 #include "word_cache.h"
+#include "superinstructions.h"
+#include "jit.h"
+#include "optimizer.h"
+#include "profiler.h"
 #include "forth_state.h"
 #include "stdlib.h"
 #include "sef_io.h"
@@ -25,6 +29,8 @@ typedef sef_int_t* dictionary_entry_t;
 #include "dictionary.h"
 #include "parser.h"
 #include "block_c_func.h"
+#include "image.h"
+#include "shared_dictionary.h"
 
 #endif
 
@@ -0,0 +1,371 @@
+#include "private_api.h"
+#include "string.h"
+#include "stdio.h"
+
+/* ---------------------------- Word profiling ------------------------------ */
+
+#if SEF_PROFILE
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define PROFILE_TABLE_SIZE 4096
+#define PROFILE_MAX_FRAMES (2 * SEF_RETURN_STACK_SIZE)
+
+struct word_profile_s {
+    dictionary_entry_t entry;
+    sef_unsigned_t calls;
+    uint64_t inclusive;
+    uint64_t exclusive;
+    sef_unsigned_t active; // Number of open frames of the word
+};
+
+// A frame is opened for each word called while profiling. When it is closed,
+// its time is added to the exclusive time of the word and to the time of the
+// children of the frame under it. Reading the clock costs more than the rest of
+// a call, so it is only read when frames are closed, and a frame starts when
+// the last one was closed. The time a word runs before calling another one is
+// then counted in the word called, unless a word returned in between.
+struct frame_s {
+    struct word_profile_s* word;
+    sef_int_t depth;
+    uint64_t start;
+    uint64_t children;
+};
+
+// This is global to all states, as the segfault recovery.
+bool sef_profiling = false;
+static struct word_profile_s words[PROFILE_TABLE_SIZE];
+static struct frame_s frames[PROFILE_MAX_FRAMES];
+static size_t frame_count = 0;
+static uint64_t last_ticks; // When the last frame was closed
+static uint64_t start_ticks, stop_ticks;
+static struct timespec start_time, stop_time;
+
+// rdtsc is much cheaper than clock_gettime. Ticks are converted to time by
+// comparing both clocks over the whole profile.
+static inline uint64_t ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+// The words are indexed by their address. Only the words colliding with
+// another one need to be searched for.
+static struct word_profile_s* search_word(dictionary_entry_t entry, size_t index) {
+    for (size_t i=1; i<PROFILE_TABLE_SIZE; i++) {
+        struct word_profile_s* word = &words[(index + i) % PROFILE_TABLE_SIZE];
+        if (word->entry == entry) {
+            return word;
+        }
+        if (word->entry == NULL) {
+            word->entry = entry;
+            return word;
+        }
+    }
+    return NULL; // The table is full, this word is not profiled
+}
+
+static inline struct word_profile_s* find_word(dictionary_entry_t entry) {
+    size_t index = ((size_t) entry / sizeof(sef_int_t)) % PROFILE_TABLE_SIZE;
+    struct word_profile_s* word = &words[index];
+    if (word->entry == entry) {
+        return word;
+    }
+    if (word->entry == NULL) {
+        word->entry = entry;
+        return word;
+    }
+    return search_word(entry, index);
+}
+
+size_t sef_profile_call(dictionary_entry_t entry, sef_int_t depth) {
+    struct word_profile_s* word = find_word(entry);
+    if (word == NULL || frame_count == PROFILE_MAX_FRAMES) {
+        return frame_count;
+    }
+    word->calls++;
+    word->active++;
+    struct frame_s* frame = &frames[frame_count];
+    frame->word = word;
+    frame->depth = depth;
+    frame->children = 0;
+    frame->start = last_ticks;
+    return frame_count++;
+}
+
+static void close_frame(uint64_t now) {
+    struct frame_s* frame = &frames[--frame_count];
+    uint64_t elapsed = now - frame->start;
+    frame->word->exclusive += elapsed - frame->children;
+    // The time of recursive calls is already part of the outermost one
+    if (--frame->word->active == 0) {
+        frame->word->inclusive += elapsed;
+    }
+    if (frame_count > 0) {
+        frames[frame_count - 1].children += elapsed;
+    }
+}
+
+void sef_profile_return(sef_int_t depth) {
+    if (frame_count == 0 || frames[frame_count - 1].depth <= depth) {
+        return;
+    }
+    last_ticks = ticks();
+    while (frame_count > 0 && frames[frame_count - 1].depth > depth) {
+        close_frame(last_ticks);
+    }
+}
+
+void sef_profile_leave(size_t frame) {
+    last_ticks = ticks();
+    while (frame_count > frame) {
+        close_frame(last_ticks);
+    }
+}
+
+void sef_profile_unwind(void) {
+    sef_profile_leave(0);
+}
+
+void sef_start_profiling(forth_state_t* fs) {
+    UNUSED(fs);
+    memset(words, 0, sizeof(words));
+    frame_count = 0;
+    sef_profiling = true;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    start_ticks = ticks();
+    last_ticks = start_ticks;
+}
+
+void sef_stop_profiling(forth_state_t* fs) {
+    UNUSED(fs);
+    if (!sef_profiling) {
+        return;
+    }
+    sef_profile_unwind();
+    sef_profiling = false;
+    clock_gettime(CLOCK_MONOTONIC, &stop_time);
+    stop_ticks = ticks();
+}
+
+// Duration of the profile in microseconds and number of microseconds per tick.
+static double profile_duration(double* us_per_tick) {
+    struct timespec end = stop_time;
+    uint64_t end_ticks = stop_ticks;
+    if (sef_profiling) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        end_ticks = ticks();
+    }
+    double duration = (end.tv_sec - start_time.tv_sec) * 1e6 + (end.tv_nsec - start_time.tv_nsec) / 1e3;
+    *us_per_tick = end_ticks > start_ticks ? duration / (end_ticks - start_ticks) : 0;
+    return duration;
+}
+
+static int compare_words(const void* a, const void* b) {
+    uint64_t exclusive_a = (*(struct word_profile_s* const*) a)->exclusive;
+    uint64_t exclusive_b = (*(struct word_profile_s* const*) b)->exclusive;
+    return (exclusive_a < exclusive_b) - (exclusive_a > exclusive_b);
+}
+
+// Fill `sorted` with the words called and return their number.
+static size_t sort_words(struct word_profile_s** sorted) {
+    size_t count = 0;
+    for (size_t i=0; i<PROFILE_TABLE_SIZE; i++) {
+        if (words[i].calls != 0) {
+            sorted[count++] = &words[i];
+        }
+    }
+    qsort(sorted, count, sizeof(struct word_profile_s*), compare_words);
+    return count;
+}
+
+size_t sef_profile_entries(sef_profile_entry_t* entries, size_t max) {
+    static struct word_profile_s* sorted[PROFILE_TABLE_SIZE];
+    double us_per_tick;
+    profile_duration(&us_per_tick);
+    size_t count = sort_words(sorted);
+    for (size_t i=0; i<count && i<max; i++) {
+        entries[i].name = sef_get_entry_name(sorted[i]->entry);
+        entries[i].calls = sorted[i]->calls;
+        entries[i].inclusive_us = sorted[i]->inclusive * us_per_tick;
+        entries[i].exclusive_us = sorted[i]->exclusive * us_per_tick;
+    }
+    return count;
+}
+
+void sef_print_profile(forth_state_t* fs) {
+    UNUSED(fs);
+    static struct word_profile_s* sorted[PROFILE_TABLE_SIZE];
+    char line[100];
+    double us_per_tick;
+    double duration = profile_duration(&us_per_tick);
+    size_t count = sort_words(sorted);
+    snprintf(line, sizeof(line), "Profile of %.3f ms:\n", duration / 1e3);
+    sef_print_string(line);
+    sef_print_string("       calls  inclusive us  exclusive us      %  word\n");
+    for (size_t i=0; i<count; i++) {
+        double exclusive = sorted[i]->exclusive * us_per_tick;
+        snprintf(line, sizeof(line), "%12lu %13.1f %13.1f %6.2f  ",
+                 (unsigned long) sorted[i]->calls, sorted[i]->inclusive * us_per_tick,
+                 exclusive, duration > 0 ? 100 * exclusive / duration : 0);
+        sef_print_string(line);
+        sef_print_string(sef_get_entry_name(sorted[i]->entry));
+        sef_print_string("\n");
+    }
+}
+#endif
+
+/* --------------------------- Sampling profiler ---------------------------- */
+
+#if SEF_SAMPLING_PROFILER
+#include <signal.h>
+#include <sys/time.h>
+
+#define MAX_SAMPLES 16384
+#define SAMPLE_MAX_DEPTH 32
+
+// The innermost return addresses when the sample was taken, outermost first,
+// and the code pointer. Once resolved, those are replaced by the words
+// running, outermost first.
+struct sample_s {
+    sef_int_t* code_pointer;
+    size_t depth;
+    sef_int_t* frames[SAMPLE_MAX_DEPTH + 2];
+};
+
+// This is global to all states, as the segfault recovery. The signal handler
+// only appends to the preallocated samples, so it takes no lock and never
+// allocates. The samples are read once the timer is stopped.
+static forth_state_t* sampled_state = NULL;
+static struct sample_s samples[MAX_SAMPLES];
+static size_t sample_count = 0;
+static size_t dropped_samples = 0;
+static struct sigaction previous_action;
+
+static void take_sample(int sig) {
+    UNUSED(sig);
+    forth_state_t* fs = sampled_state;
+    size_t index = __atomic_load_n(&sample_count, __ATOMIC_RELAXED);
+    if (fs == NULL || index == MAX_SAMPLES) {
+        dropped_samples++;
+        return;
+    }
+    struct sample_s* sample = &samples[index];
+    sample->code_pointer = fs->code_pointer;
+    sef_int_t depth = fs->return_stack_index;
+    if (depth < 0 || depth > fs->return_stack_size) {
+        depth = 0;
+    }
+    size_t kept = depth < SAMPLE_MAX_DEPTH ? (size_t) depth : SAMPLE_MAX_DEPTH;
+    for (size_t i=0; i<kept; i++) {
+        sample->frames[i] = (sef_int_t*) fs->return_stack[depth - kept + i];
+    }
+    sample->depth = kept;
+    __atomic_store_n(&sample_count, index + 1, __ATOMIC_RELEASE);
+}
+
+bool sef_sampler_start(forth_state_t* fs, unsigned int interval_us) {
+    sampled_state = fs;
+    sample_count = 0;
+    dropped_samples = 0;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sa.sa_handler = take_sample;
+    if (sigaction(SIGPROF, &sa, &previous_action) != 0) {
+        return false;
+    }
+    struct itimerval timer = {
+        .it_interval = {interval_us / 1000000, interval_us % 1000000},
+        .it_value = {interval_us / 1000000, interval_us % 1000000},
+    };
+    return setitimer(ITIMER_PROF, &timer, NULL) == 0;
+}
+
+// Tells if the given cell is in the dictionary and holds a word.
+static bool is_call(forth_state_t* fs, sef_int_t* cell) {
+    if (sef_try_to_find_entry(fs, cell) == NULL) {
+        return false;
+    }
+    dictionary_entry_t word = (dictionary_entry_t) *cell;
+    return word != NULL && sef_try_to_find_entry(fs, word) == word;
+}
+
+// Replace the addresses of a sample by the words running. A return address
+// points to the call to the word that returns there, the cells that don't,
+// like the ones of the interpreter, of do-loops or pushed with `>r`, are
+// skipped. The word the code pointer is on is added after the word it is in.
+static void resolve_sample(forth_state_t* fs, struct sample_s* sample) {
+    size_t depth = 0;
+    for (size_t i=0; i<sample->depth; i++) {
+        if (is_call(fs, sample->frames[i])) {
+            sample->frames[depth++] = sef_try_to_find_entry(fs, sample->frames[i]);
+        }
+    }
+    if (is_call(fs, sample->code_pointer)) {
+        sample->frames[depth++] = sef_try_to_find_entry(fs, sample->code_pointer);
+        sample->frames[depth++] = (dictionary_entry_t) *sample->code_pointer;
+    }
+    sample->depth = depth;
+}
+
+static int compare_samples(const void* a, const void* b) {
+    const struct sample_s* sample_a = a;
+    const struct sample_s* sample_b = b;
+    for (size_t i=0; i<sample_a->depth && i<sample_b->depth; i++) {
+        if (sample_a->frames[i] != sample_b->frames[i]) {
+            return sample_a->frames[i] < sample_b->frames[i] ? -1 : 1;
+        }
+    }
+    return (sample_a->depth > sample_b->depth) - (sample_a->depth < sample_b->depth);
+}
+
+static void write_stack(FILE* f, const struct sample_s* sample, size_t count) {
+    if (sample->depth == 0) {
+        fprintf(f, "(interpreter)");
+    }
+    for (size_t i=0; i<sample->depth; i++) {
+        fprintf(f, "%s%s", i == 0 ? "" : ";", sef_get_entry_name(sample->frames[i]));
+    }
+    fprintf(f, " %lu\n", (unsigned long) count);
+}
+
+bool sef_sampler_stop(forth_state_t* fs, const char* path) {
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &previous_action, NULL);
+    sampled_state = NULL;
+    size_t count = __atomic_load_n(&sample_count, __ATOMIC_ACQUIRE);
+
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+    for (size_t i=0; i<count; i++) {
+        resolve_sample(fs, &samples[i]);
+    }
+
+    // Identical stacks are next to each other once sorted
+    qsort(samples, count, sizeof(struct sample_s), compare_samples);
+    size_t first = 0;
+    for (size_t i=1; i<=count; i++) {
+        if (i == count || compare_samples(&samples[first], &samples[i]) != 0) {
+            write_stack(f, &samples[first], i - first);
+            first = i;
+        }
+    }
+    if (dropped_samples != 0) {
+        warn_msg("%lu samples were dropped as the buffer was full.\n", (unsigned long) dropped_samples);
+    }
+    return fclose(f) == 0;
+}
+#endif
+
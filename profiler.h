@@ -0,0 +1,75 @@
+#include "private_api.h"
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#if SEF_PROFILE
+// Set while the profiler is counting. The engines check it before calling the
+// functions below so that a stopped profiler costs a single test.
+extern bool sef_profiling;
+
+// Must be called when the given word starts. The depth is the index of the
+// return stack once the word has pushed its return address; the word is over
+// when the return stack goes back under it. Return the index of the frame
+// opened for the word, to be given to sef_profile_leave for words that don't
+// return through EXIT.
+size_t sef_profile_call(dictionary_entry_t entry, sef_int_t depth);
+
+// Must be called when a return address has been popped, with the index of the
+// return stack after it. This closes the frames of the words that returned.
+void sef_profile_return(sef_int_t depth);
+
+// Close the given frame, and the ones opened after it, if they are still open.
+void sef_profile_leave(size_t frame);
+
+// Close all frames, as the return stack has been emptied.
+void sef_profile_unwind(void);
+
+// Forth words to clear the counts and start profiling, to stop it, and to
+// print the words profiled, sorted by exclusive time.
+void sef_start_profiling(forth_state_t* fs);
+void sef_stop_profiling(forth_state_t* fs);
+void sef_print_profile(forth_state_t* fs);
+
+// Fill the given array with up to `max` words profiled, sorted by exclusive
+// time, and return the number of words profiled. This is sef_get_profile.
+size_t sef_profile_entries(sef_profile_entry_t* entries, size_t max);
+
+#define PROFILE_CALL(entry, depth)       \
+    if (sef_profiling) {                 \
+        sef_profile_call(entry, depth);  \
+    }
+
+#define PROFILE_RETURN(depth)            \
+    if (sef_profiling) {                 \
+        sef_profile_return(depth);       \
+    }
+
+// C words don't return through EXIT, their frame is closed once `call` is done.
+#define PROFILE_C_WORD(fs, entry, call) {                                     \
+        size_t profile_frame = sef_profiling ?                                \
+            sef_profile_call(entry, (fs)->return_stack_index) : SIZE_MAX;     \
+        call;                                                                 \
+        if (profile_frame != SIZE_MAX) {                                      \
+            sef_profile_leave(profile_frame);                                 \
+        }                                                                     \
+    }
+#else
+#define PROFILE_CALL(entry, depth)
+#define PROFILE_RETURN(depth)
+#define PROFILE_C_WORD(fs, entry, call) call
+#endif
+
+#if SEF_SAMPLING_PROFILER
+// Start sampling the given state every `interval_us` microseconds of CPU time.
+// Return false if the timer couldn't be set.
+bool sef_sampler_start(forth_state_t* fs, unsigned int interval_us);
+
+// Stop sampling and write the samples to the given file as folded stacks, one
+// line per stack with the words from the outermost one, separated by `;`,
+// followed by the number of samples. Return false if the file couldn't be
+// written.
+bool sef_sampler_stop(forth_state_t* fs, const char* path);
+#endif
+
+#endif
+
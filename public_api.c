@@ -3,9 +3,50 @@
 
 void sef_init(sef_forth_state_t* _state) {
     forth_state_t* state = (forth_state_t*) _state;
+    sef_state_set_regions(state, NULL);
     sef_state_init(state);
 }
 
+#if SEF_IMAGE
+bool sef_load_image(sef_forth_state_t* _state, const char* path) {
+    forth_state_t* state = (forth_state_t*) _state;
+    sef_state_set_regions(state, NULL);
+    return sef_image_load(state, path);
+}
+
+bool sef_save_image(sef_forth_state_t* _state, const char* path) {
+    forth_state_t* state = (forth_state_t*) _state;
+    return sef_image_save(state, path);
+}
+#endif
+
+#if SEF_SHARED_DICTIONARY
+sef_shared_dictionary_t* sef_new_shared_dictionary(void) {
+    return sef_shared_dictionary_new();
+}
+
+void sef_init_shared(sef_forth_state_t* _state, const sef_shared_dictionary_t* dictionary) {
+    forth_state_t* state = (forth_state_t*) _state;
+    sef_state_set_regions(state, NULL);
+    sef_shared_state_init(state, dictionary);
+}
+
+void sef_free_shared_dictionary(sef_shared_dictionary_t* dictionary) {
+    sef_shared_dictionary_free(dictionary);
+}
+#endif
+
+#if SEF_MAPPED_STATES
+sef_forth_state_t* sef_create(const sef_options_t* options) {
+    return (sef_forth_state_t*) sef_state_create(options);
+}
+
+void sef_destroy(sef_forth_state_t* _state) {
+    forth_state_t* state = (forth_state_t*) _state;
+    sef_state_destroy(state);
+}
+#endif
+
 void sef_restart(sef_forth_state_t* _state) {
     forth_state_t* state = (forth_state_t*) _state;
     sef_reset(state);
@@ -31,12 +72,32 @@ int sef_exit_code(sef_forth_state_t* _state) {
     return state->exit_code;
 }
 
-void sef_eval_string(sef_forth_state_t* _state, const char* s) {
+sef_unsigned_t sef_dictionary_probes(sef_forth_state_t* _state) {
     forth_state_t* state = (forth_state_t*) _state;
-    sef_set_c_string_as_input_source(state, s);
+    return state->dictionary_probes;
+}
+
+struct buffer_s {
+    const char* text;
+    size_t size;
+};
+
+static void eval_buffer(forth_state_t* state, const void* arg) {
+    const struct buffer_s* buffer = arg;
+    sef_set_c_buffer_as_input_source(state, buffer->text, buffer->size);
     sef_inter_compil_run(state);
 }
 
+void sef_eval_buffer(sef_forth_state_t* _state, const char* buffer, size_t size) {
+    forth_state_t* state = (forth_state_t*) _state;
+    const struct buffer_s arg = {.text = buffer, .size = size};
+    sef_call_with_segfault_recovery(state, eval_buffer, &arg);
+}
+
+void sef_eval_string(sef_forth_state_t* state, const char* s) {
+    sef_eval_buffer(state, s, strlen(s));
+}
+
 void sef_push_to_data_stack(sef_forth_state_t* _state, sef_int_t w) {
     forth_state_t* state = (forth_state_t*) _state;
     sef_push_data(state, w);
@@ -49,6 +110,11 @@ sef_int_t sef_pop_from_data_stack(sef_forth_state_t* _state) {
 
 void sef_register_c_word(sef_forth_state_t* _state, const char* name, sef_c_word func, bool is_immediate) {
     forth_state_t* state = (forth_state_t*) _state;
+#if SEF_IMAGE
+    if (sef_image_rebind_cfunc(state, name, (void (*)(forth_state_t*)) func, is_immediate)) {
+        return;
+    }
+#endif
     sef_register_cfunc(state, name, (void (*)(forth_state_t*)) func, is_immediate);
 }
 
@@ -81,3 +147,32 @@ void sef_feed_arguments(sef_forth_state_t* _state, int argc, char** argv) {
 
 #endif
 
+#if SEF_PROFILE
+void sef_profile_start(sef_forth_state_t* _state) {
+    forth_state_t* state = (forth_state_t*) _state;
+    sef_start_profiling(state);
+}
+
+void sef_profile_stop(sef_forth_state_t* _state) {
+    forth_state_t* state = (forth_state_t*) _state;
+    sef_stop_profiling(state);
+}
+
+size_t sef_get_profile(sef_forth_state_t* _state, sef_profile_entry_t* entries, size_t max) {
+    UNUSED(_state);
+    return sef_profile_entries(entries, max);
+}
+#endif
+
+#if SEF_SAMPLING_PROFILER
+bool sef_start_sampling(sef_forth_state_t* _state, unsigned int interval_us) {
+    forth_state_t* state = (forth_state_t*) _state;
+    return sef_sampler_start(state, interval_us);
+}
+
+bool sef_stop_sampling(sef_forth_state_t* _state, const char* path) {
+    forth_state_t* state = (forth_state_t*) _state;
+    return sef_sampler_stop(state, path);
+}
+#endif
+
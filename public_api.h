@@ -12,11 +12,85 @@ typedef sef_int_t sef_forth_state_t[SEF_STATE_SIZE_INT];
 >> This function must be called on the Forth state before using it.
 void sef_init(sef_forth_state_t* state);
 
+>> Called by `sef_init`, if `SEF_PRECOMPILED_DICTIONARY` is 0, after each set
+>> of system words is compiled, with the name of the set, such as
+>> `core_forth_words`, and once before the first one with `C words`. It does
+>> nothing by default but, as it is weak, it can be overridden to measure how
+>> long each set takes to compile.
+void sef_system_words_compiled(sef_forth_state_t* state, const char* set_name);
+
+#if SEF_IMAGE
+>> Initialize the state from an image written by `sef_save_image` or
+>> `save-image`, in place of `sef_init`. This maps the file and copies it in the
+>> state, which is much faster than compiling the system words. The image must
+>> have been saved by the same build of SEForth. Return false if it couldn't be
+>> loaded, in which case the state must be initialized with `sef_init`.
+bool sef_load_image(sef_forth_state_t* state, const char* path);
+
+>> Write the dictionary and the memory addressed by HERE to the file at `path`,
+>> as `save-image`. Return false if it couldn't be written.
+bool sef_save_image(sef_forth_state_t* state, const char* path);
+#endif
+
+#if SEF_SHARED_DICTIONARY
+>> System words compiled once and used by any number of states.
+typedef struct sef_shared_dictionary_s sef_shared_dictionary_t;
+
+>> Compile the system words in a new read-only memory mapping. Return NULL if
+>> it couldn't be made.
+sef_shared_dictionary_t* sef_new_shared_dictionary(void);
+
+>> Initialize the state, in place of `sef_init`, to search the shared
+>> dictionary after its own words. Only the variables and values of the system
+>> are copied in the state, so this is almost free and, as the pages of the
+>> state that are never written aren't allocated by most systems, a state that
+>> isn't used to define many words only takes a few kB. The dictionary must be
+>> kept until the state isn't used anymore. An image of the state can't be
+>> saved.
+void sef_init_shared(sef_forth_state_t* state, const sef_shared_dictionary_t* dictionary);
+
+>> Unmap a shared dictionary.
+void sef_free_shared_dictionary(sef_shared_dictionary_t* dictionary);
+#endif
+
+>> Sizes of the regions of a state made by `sef_create`. The sizes set to 0 are
+>> the ones of the configuration.
+typedef struct {
+    size_t memory_size; >> Bytes of the memory addressed by HERE.
+    size_t data_stack_size; >> Cells of the data stack.
+    size_t return_stack_size; >> Cells of the return stack.
+    size_t control_flow_stack_size; >> Cells of the control flow stack.
+    bool huge_pages; >> Map the state with huge pages if possible.
+#if SEF_SHARED_DICTIONARY
+    const sef_shared_dictionary_t* shared_dictionary; >> If set, initialize the state as `sef_init_shared`.
+#endif
+} sef_options_t;
+
+#if SEF_MAPPED_STATES
+>> Map a state with the sizes of the options, which can be NULL, and initialize
+>> it as `sef_init`. The pages of the state are only allocated by the system
+>> when they are first written, so a state takes little memory until its
+>> dictionary grows. The state must be freed with `sef_destroy` and must not be
+>> given to `sef_init`, `sef_load_image` or `sef_init_shared`, which are meant
+>> for states of `sizeof(sef_forth_state_t)` bytes. With `SEF_STACK_GUARD_PAGES`,
+>> its stacks are mapped between guard pages. Return NULL if it couldn't be
+>> mapped.
+sef_forth_state_t* sef_create(const sef_options_t* options);
+
+>> Unmap a state made by `sef_create`.
+void sef_destroy(sef_forth_state_t* state);
+#endif
+
 >> -------------------------- Executing Forth code -------------------------- >>
 
 >> Parse and execute the null-terminated string of Forth code `s`.
 void sef_eval_string(sef_forth_state_t* state, const char* s);
 
+>> Parse and execute the `size` chars of Forth code at `buffer`, which doesn't
+>> need to be null-terminated and isn't copied, such as a file mapped in memory.
+>> The time taken to read it is linear in its size.
+void sef_eval_buffer(sef_forth_state_t* state, const char* buffer, size_t size);
+
 >> Force the interpretation of a string, even if the state isn't ready to
 >> interpret. If the state wasn't ready to run, call sef_restart before. If the
 >> state is compiling, put it back in interpreting mode before evaluating the
@@ -47,6 +121,10 @@ bool sef_is_compiling(sef_forth_state_t* state);
 >> or 0 if it hasn't.
 int sef_exit_code(sef_forth_state_t* state);
 
+>> Return the number of dictionary entries compared to a name since `sef_init`,
+>> while looking up words.
+sef_unsigned_t sef_dictionary_probes(sef_forth_state_t* state);
+
 #ifdef SEF_ARG_AND_EXIT_CODE
 >> This is only available if `___SEF_ARG_AND_EXIT_CODE` is set. This let you feed
 >> command line arguments to SEForth by calling
@@ -77,6 +155,41 @@ void sef_register_c_word(sef_forth_state_t* state,
                          const char* name,
                          sef_c_word func,
                          bool is_immediate);
+#if SEF_PROFILE
+>> -------------------------------- Profiling ------------------------------- >>
+
+>> Profile of a word, as given by `sef_get_profile`. The inclusive time counts
+>> the words it calls and the exclusive time doesn't.
+typedef struct {
+    const char* name;
+    unsigned long calls;
+    double inclusive_us;
+    double exclusive_us;
+} sef_profile_entry_t;
+
+>> Clear the profile and start profiling, as `profile-start`.
+void sef_profile_start(sef_forth_state_t* state);
+
+>> Stop profiling, as `profile-stop`.
+void sef_profile_stop(sef_forth_state_t* state);
+
+>> Fill `entries` with up to `max` words profiled, sorted by exclusive time, and
+>> return the number of words profiled. The names point into the dictionary.
+size_t sef_get_profile(sef_forth_state_t* state, sef_profile_entry_t* entries, size_t max);
+#endif
+
+#if SEF_SAMPLING_PROFILER
+>> --------------------------- Sampling profiler --------------------------- >>
+
+>> Start sampling the words run by the state every `interval_us` microseconds
+>> of CPU time. Return false if the timer couldn't be set.
+bool sef_start_sampling(sef_forth_state_t* state, unsigned int interval_us);
+
+>> Stop sampling and write the samples to the file at `path` as folded stacks,
+>> as read by flame graph tools. Return false if it couldn't be written.
+bool sef_stop_sampling(sef_forth_state_t* state, const char* path);
+#endif
+
 #if SEF_BLOCK
 >> --------------------------------- Blocks --------------------------------- >>
 
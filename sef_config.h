@@ -39,6 +39,10 @@
 #define SEF_ARG_AND_EXIT_CODE 1
 #endif
 
+#ifndef SEF_SEARCH_ORDER
+#define SEF_SEARCH_ORDER 1
+#endif
+
 // ------------------------------- Memory used ------------------------------ //
 
 // Number of cells in the return stack.
@@ -67,6 +71,13 @@
 #define SEF_PAD_SIZE 100
 #endif
 
+// Number of lists in the hash index used to find words in the dictionary. Each
+// of them takes a cell in the Forth state. With more words than lists, finding
+// a word gets slower.
+#ifndef SEF_DICTIONARY_BUCKETS
+#define SEF_DICTIONARY_BUCKETS 1024
+#endif
+
 // Number of block buffer available. They are stored in the memory indexed by
 // HERE. Only relevant if the block word set is enabled.
 #ifndef SEF_NUMBER_OF_BLOCK_BUFFERS
@@ -109,14 +120,184 @@
 #endif
 
 // With this option set to 1, segfaults caused by Forth code will be caught and
-// the interpreter will be put back into an idle state if encountered. This
-// relies on static variable and thus, this prevent the interpreter to be used
-// on multiple threads. Furthermore, the system running SEForth needs to
-// support POSIX signals.
+// the interpreter will be put back into an idle state if encountered. The
+// recovery point is kept per thread, so states can run on different threads,
+// and the segfaults that don't come from Forth code are given to the handler
+// installed before, if any. Furthermore, the system running SEForth needs to
+// support POSIX signals. The signal handler is installed by `sef_init` and
+// recovery is armed once per call to `sef_eval_string`, so it costs nothing
+// when words are executed.
 #ifndef SEF_CATCH_SEGFAULTS
 #define SEF_CATCH_SEGFAULTS 1
 #endif
 
+// If set to 1, words are executed by a single dispatch loop where each
+// primitive is a label and where dispatching a word is an indirect jump. This is
+// much faster but requires the labels-as-values extension of GCC and Clang. If
+// set to 0, a portable engine that calls each word through a function pointer
+// is used.
+#ifndef SEF_DIRECT_THREADING
+#define SEF_DIRECT_THREADING 1
+#endif
+
+// If set to 1 and the threaded engine is used, the top of the data stack is
+// kept in a register of the engine and the primitives work on the stacks
+// without checking them; stack bounds are checked once before each word is
+// dispatched. This makes arithmetic-heavy code faster. If set to 0, the
+// threaded engine executes the primitives through the same functions as the
+// portable engine.
+#ifndef SEF_STACK_CACHING
+#define SEF_STACK_CACHING 1
+#endif
+
+// If set to 1, some frequent sequences of words, such as `dup if` or `over
+// over`, are replaced by a single superinstruction when they are compiled,
+// which saves dispatching the words of the sequence one by one.
+#ifndef SEF_SUPERINSTRUCTIONS
+#define SEF_SUPERINSTRUCTIONS 1
+#endif
+
+// If set to 1, the interpreter counts how many times each pair of words is
+// executed one after the other, and the word `.pairs` prints the most frequent
+// pairs. This is meant to find new sequences worth a superinstruction. It slows
+// down the interpreter and, as it relies on static variables, prevents using it
+// on multiple threads.
+#ifndef SEF_PROFILE_PAIRS
+#define SEF_PROFILE_PAIRS 0
+#endif
+
+// If set to 1, the words `profile-start`, `profile-stop` and `profile-report`
+// count the calls to each word and measure the time spent in it, with and
+// without the words it calls, and print them sorted by the time spent in the
+// word itself. The functions `sef_profile_start`, `sef_profile_stop` and
+// `sef_get_profile` do the same from C. Primitives, words made with `create`
+// and words that are inlined, tail-called or called from machine code are
+// counted as part of the word running them. The clock is only read when a word
+// returns, so the time a word runs before calling another one is counted in the
+// word called, unless a word returned in between. Running, it does not stay
+// under 10% of overhead: reading the clock once per call, about 20 ns, makes
+// code calling a word every 30 ns about twice as slow and recursive code such
+// as `fib` about 20% slower; `SEF_SAMPLING_PROFILER` is lighter for such code.
+// A stopped profiler costs a test per call and per return. As it relies on
+// static variables, it prevents using the interpreter on multiple threads.
+#ifndef SEF_PROFILE
+#define SEF_PROFILE 0
+#endif
+
+// If set to 1, the functions `sef_start_sampling` and `sef_stop_sampling`, or
+// the `--profile <file>` option of `seforth`, sample the words running with a
+// `SIGPROF` timer and write the samples as folded stacks, which flame graph
+// tools can read. Unlike `SEF_PROFILE`, calls are not counted, which keeps the
+// loops measured undisturbed; the threaded engine only saves its code pointer
+// and return stack index before each word. Words compiled by the JIT are seen
+// from the last word they ran through the threaded engine. It needs POSIX
+// signals and, as it relies on static variables, prevents using the interpreter
+// on multiple threads.
+#ifndef SEF_SAMPLING_PROFILER
+#define SEF_SAMPLING_PROFILER 0
+#endif
+
+// If set to 1, the most used core words, such as `over`, `2dup`, `1+`, `max`,
+// `/` or `aligned`, are implemented in C. If set to 0, they are defined in
+// Forth, which is slower but makes the interpreter a bit smaller.
+#ifndef SEF_NATIVE_CORE_WORDS
+#define SEF_NATIVE_CORE_WORDS 1
+#endif
+
+// If set to 1, a call to a Forth word followed by `EXIT` or `;` is compiled as
+// a jump, so that the word called returns directly to the caller of the word
+// being defined. This saves a push and a pop of the return stack for each of
+// those calls and lets tail-recursive words run in constant return stack
+// space. The words skipped that way are missing from stack traces.
+#ifndef SEF_TAIL_CALLS
+#define SEF_TAIL_CALLS 1
+#endif
+
+// If set to more than 0, a call to a colon definition of at most that many
+// cells, not counting its `EXIT`, is replaced by a copy of its body when it is
+// compiled. This is only done for words without branches or loops that don't
+// use the return stack. The word `noinline` prevents it for the last word
+// defined. The words inlined are missing from stack traces.
+#ifndef SEF_INLINE_MAX_CELLS
+#define SEF_INLINE_MAX_CELLS 4
+#endif
+
+// If set to 1, colon definitions are simplified when they are finished.
+// Arithmetic on literals, such as `3 4 + cells`, is done at compile time, a
+// literal compared to 0 uses `0=` and the like, and sequences doing nothing,
+// such as `swap swap`, `dup drop` or `0 +`, are removed. The word
+// `optimized-cells` gives the number of cells saved so far, which right after
+// startup is what was saved on the system words.
+#ifndef SEF_OPTIMIZER
+#define SEF_OPTIMIZER 1
+#endif
+
+// If set to 1, colon definitions are compiled to x86-64 machine code when they
+// are finished. Words that can't be compiled, and words called from the machine
+// code that have no template, are run by the threaded engine. This only works on
+// x86-64 Linux with `SEF_DIRECT_THREADING` set to 1 and is ignored elsewhere. It
+// maps a buffer of executable memory and relies on static variables, which
+// prevents using it on multiple threads.
+#ifndef SEF_JIT
+#define SEF_JIT 0
+#endif
+
+// If set to 1, the word `save-image` and the function `sef_save_image` write
+// the dictionary and the memory addressed by HERE to a file, and
+// `sef_load_image`, or the `--image <file>` option of `seforth`, start a state
+// from such a file instead of compiling the system words. The C words of the
+// system are bound again to the functions at the same place in the tables of C
+// words, the other ones must be registered again with `sef_register_c_word`.
+// Files, allocated memory and the block file are not kept in the image. It
+// needs POSIX `mmap`.
+#ifndef SEF_IMAGE
+#define SEF_IMAGE 1
+#endif
+
+// If set to 1, the system words are compiled when libseforth is built and
+// `sef_init` copies the dictionary made then in the state, instead of compiling
+// the Forth source of the system words, which makes starting much faster. The
+// source is then not linked in the programs using the library, but the
+// dictionary is bigger than it, around 34 kB against 6 kB on x86-64, so the
+// programs get bigger. As a program built for the target runs during the
+// build, set it to 0 when cross-compiling, which the Makefile then skips.
+// `sef_system_words_compiled` is only called when this is set to 0.
+#ifndef SEF_PRECOMPILED_DICTIONARY
+#define SEF_PRECOMPILED_DICTIONARY 1
+#endif
+
+// If set to 1, `sef_new_shared_dictionary` compiles the system words once in a
+// read-only memory mapping, and `sef_init_shared` starts a state searching it
+// after its own dictionary, instead of holding a copy of the system words.
+// Only the bodies of the variables and values of the system, a few kB, are
+// copied in the state. It needs POSIX `mmap`.
+#ifndef SEF_SHARED_DICTIONARY
+#define SEF_SHARED_DICTIONARY 1
+#endif
+
+// If set to 1, `sef_create` maps a state whose memory addressed by HERE and
+// stacks are sized at runtime, instead of the sizes set here, and `sef_destroy`
+// unmaps it. Only the pages written are allocated, and the registers of the
+// interpreter share the first cache line of the state. It needs POSIX `mmap`.
+#ifndef SEF_MAPPED_STATES
+#define SEF_MAPPED_STATES 1
+#endif
+
+// If set to 1, each stack of the states made by `sef_create` is mapped between
+// two guard pages that can't be accessed, and overflowing or underflowing it is
+// caught by the segfault handler, which aborts the state as the bound checks
+// do. The stacks are then only compared to their size for underflows of the
+// data stack, as the threaded engine spills the top of an empty data stack in
+// the cell under it, and they are made as big as their pages allow. The stacks
+// of the states initialized by `sef_init`, `sef_load_image` or
+// `sef_init_shared` have no guard pages and are still checked as set by
+// `SEF_STACK_BOUND_CHECKS`, a test per word slowing down the states made by
+// `sef_create` a bit. HERE is still checked if `SEF_STACK_BOUND_CHECKS` is set.
+// It needs `SEF_MAPPED_STATES` and `SEF_CATCH_SEGFAULTS`.
+#ifndef SEF_STACK_GUARD_PAGES
+#define SEF_STACK_GUARD_PAGES 0
+#endif
+
 // If the block word set is enabled, setting this option to 1 lets the user of
 // the SEForth API provide a file that will be used to store blocks. If it
 // is set to 0, the API user will have to provide the functions to write or read
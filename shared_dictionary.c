@@ -0,0 +1,232 @@
+#include "private_api.h"
+#include "string.h"
+
+#if SEF_SHARED_DICTIONARY
+#include "sys/mman.h"
+
+// A shared dictionary is made from a state where the system words were just
+// compiled. Its memory is copied in a mapping, with the cells pointing in it
+// moved there, and the bodies of the words made with `create` are copied in a
+// template of the start of the memory of the states, as each state must be
+// able to change its variables. The cells of the bodies pointing in the state
+// the dictionary was made from, such as the address of the exit code held by
+// `exit-code`, are written relative to the start of the state.
+
+struct moved_body_s {
+    dictionary_entry_t entry;
+    uint8_t* start;
+    uint8_t* end;
+    size_t offset; // From the start of the memory of the states
+};
+
+struct builder_s {
+    forth_state_t* fs;
+    size_t used;
+    struct moved_body_s* bodies;
+    size_t body_count;
+    sef_shared_dictionary_t* shared;
+    uint8_t* data;
+    uint8_t* data_relocations;
+};
+
+static bool points_in_state(forth_state_t* fs, sef_unsigned_t value) {
+    return value >= (sef_unsigned_t) fs && value < (sef_unsigned_t) fs + fs->size;
+}
+
+static bool points_in_memory(struct builder_s* b, sef_unsigned_t value) {
+    return value >= (sef_unsigned_t) b->fs->forth_memory && value < (sef_unsigned_t) b->fs->forth_memory + b->used;
+}
+
+static const struct moved_body_s* moved_body_of(struct builder_s* b, sef_unsigned_t value) {
+    size_t low = 0, high = b->body_count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (value < (sef_unsigned_t) b->bodies[middle].start) {
+            high = middle;
+        } else if (value >= (sef_unsigned_t) b->bodies[middle].end) {
+            low = middle + 1;
+        } else {
+            return &b->bodies[middle];
+        }
+    }
+    return NULL;
+}
+
+static void* to_shared(struct builder_s* b, const void* p) {
+    if (p == NULL) {
+        return NULL;
+    }
+    return b->shared->memory + ((const uint8_t*) p - b->fs->forth_memory);
+}
+
+// The body of a word made with `create` goes up to the next entry, or to HERE
+// for the last one. Empty bodies are left in the shared dictionary, as there
+// is nothing in them to change.
+static bool find_moved_bodies(struct builder_s* b) {
+    forth_state_t* fs = b->fs;
+    b->bodies = malloc(fs->entry_count * sizeof(struct moved_body_s));
+    if (b->bodies == NULL) {
+        return false;
+    }
+    size_t data_size = 0;
+    for (sef_int_t i=0; i<fs->entry_count; i++) {
+        dictionary_entry_t entry = fs->entries[i];
+        sef_int_t kind = *sef_get_word_tag_field(entry) & WORD_KIND;
+        if (kind != WTM_CREATE && kind != WTM_DOES_EXECUTION) {
+            continue;
+        }
+        uint8_t* start = sef_get_entry_parameter(entry);
+        uint8_t* end = i + 1 < fs->entry_count ? (uint8_t*) sef_get_entry_name(fs->entries[i + 1]) : fs->here.byte;
+        size_t size = (end - start) / sizeof(sef_int_t) * sizeof(sef_int_t);
+        if (size == 0) {
+            continue;
+        }
+        b->bodies[b->body_count++] = (struct moved_body_s) {.entry = entry, .start = start, .end = start + size, .offset = data_size};
+        data_size += size;
+    }
+    b->shared->data_size = data_size;
+    return true;
+}
+
+static size_t bitmap_size(size_t cells) {
+    return (cells + 8 * sizeof(sef_int_t) - 1) / (8 * sizeof(sef_int_t)) * sizeof(sef_int_t);
+}
+
+static bool map_shared_dictionary(struct builder_s* b, sef_shared_dictionary_t* layout) {
+    size_t data_cells = layout->data_size / sizeof(sef_int_t);
+    size_t entries_size = b->fs->entry_count * sizeof(dictionary_entry_t);
+    size_t size = sizeof(sef_shared_dictionary_t) + entries_size + b->used + layout->data_size + bitmap_size(data_cells);
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    sef_shared_dictionary_t* shared = mapping;
+    *shared = *layout;
+    shared->mapped_size = size;
+    shared->entries = (dictionary_entry_t*) (shared + 1);
+    shared->memory = (uint8_t*) shared->entries + entries_size;
+    shared->memory_end = shared->memory + b->used;
+    b->data = shared->memory_end;
+    b->data_relocations = b->data + layout->data_size;
+    shared->data = b->data;
+    shared->data_relocations = b->data_relocations;
+    b->shared = shared;
+    return true;
+}
+
+// The words compiled by the system don't keep the address of a variable or of
+// the state in their code, so the cells pointing elsewhere than in the memory
+// can only be numbers looking like addresses, which are left as they are.
+static void copy_memory(struct builder_s* b) {
+    sef_unsigned_t* cells = (sef_unsigned_t*) b->shared->memory;
+    memcpy(cells, b->fs->forth_memory, b->used);
+    for (size_t i=0; i<b->used/sizeof(sef_int_t); i++) {
+        if (points_in_memory(b, cells[i])) {
+            cells[i] = (sef_unsigned_t) to_shared(b, (void*) cells[i]);
+        }
+    }
+    for (sef_int_t i=0; i<b->fs->entry_count; i++) {
+        dictionary_entry_t entry = to_shared(b, b->fs->entries[i]);
+#if SEF_JIT_ENABLED
+        // The machine code is bound to the state it was compiled for.
+        if (*sef_get_entry_code_field(entry) == OP_DONATIVE) {
+            *sef_get_entry_code_field(entry) = OP_DOCOL;
+            *sef_get_entry_special_parameters(entry) = 0;
+        }
+#endif
+        b->shared->entries[i] = entry;
+    }
+}
+
+static void copy_bodies(struct builder_s* b) {
+    sef_unsigned_t* data = (sef_unsigned_t*) b->data;
+    for (size_t i=0; i<b->body_count; i++) {
+        const struct moved_body_s* body = &b->bodies[i];
+        memcpy(b->data + body->offset, body->start, body->end - body->start);
+        dictionary_entry_t entry = to_shared(b, body->entry);
+        bool does = (*sef_get_word_tag_field(entry) & WORD_KIND) == WTM_DOES_EXECUTION;
+        *sef_get_entry_code_field(entry) = does ? OP_DOSHAREDDOES : OP_DOSHAREDCREATE;
+        *(sef_int_t*) sef_get_entry_parameter(entry) = body->offset;
+    }
+    for (size_t i=0; i<b->shared->data_size/sizeof(sef_int_t); i++) {
+        const struct moved_body_s* body = moved_body_of(b, data[i]);
+        if (body != NULL) {
+            data[i] = STATE_HEADER_SIZE + body->offset + (data[i] - (sef_unsigned_t) body->start);
+        } else if (points_in_memory(b, data[i])) {
+            data[i] = (sef_unsigned_t) to_shared(b, (void*) data[i]);
+            continue;
+        } else if (points_in_state(b->fs, data[i])) {
+            data[i] -= (sef_unsigned_t) b->fs;
+        } else {
+            continue;
+        }
+        b->data_relocations[i / 8] |= 1 << (i % 8);
+    }
+}
+
+static void copy_registers(struct builder_s* b) {
+    forth_state_t* fs = b->fs;
+    sef_shared_dictionary_t* shared = b->shared;
+    shared->last_entry = to_shared(b, fs->last_dictionary_entry);
+    shared->entry_count = fs->entry_count;
+    for (size_t i=0; i<SEF_DICTIONARY_BUCKETS; i++) {
+        shared->buckets[i] = to_shared(b, fs->dictionary_buckets[i]);
+    }
+    for (size_t i=0; i<WORD_IN_CACHE_COUNT; i++) {
+        shared->word_cache[i] = to_shared(b, fs->word_cache[i]);
+    }
+    shared->wordlist_count = fs->wordlist_count;
+    shared->optimized_cells = fs->optimized_cells;
+}
+
+sef_shared_dictionary_t* sef_shared_dictionary_new(void) {
+    struct builder_s b = {0};
+    sef_shared_dictionary_t layout = {0};
+    b.shared = &layout;
+    b.fs = malloc(DEFAULT_STATE_SIZE);
+    if (b.fs == NULL) {
+        return NULL;
+    }
+    sef_state_set_regions(b.fs, NULL);
+    sef_state_init(b.fs);
+    sef_follow_dictionary_changes(b.fs);
+    b.used = (b.fs->here.byte - b.fs->forth_memory + sizeof(sef_int_t) - 1) / sizeof(sef_int_t) * sizeof(sef_int_t);
+    bool ok = find_moved_bodies(&b) && map_shared_dictionary(&b, &layout);
+    if (ok) {
+        copy_memory(&b);
+        copy_bodies(&b);
+        copy_registers(&b);
+        mprotect(b.shared, b.shared->mapped_size, PROT_READ);
+    }
+    free(b.bodies);
+    free(b.fs);
+    return ok ? b.shared : NULL;
+}
+
+void sef_shared_dictionary_free(sef_shared_dictionary_t* shared) {
+    if (shared != NULL) {
+        munmap(shared, shared->mapped_size);
+    }
+}
+
+void sef_shared_state_init(forth_state_t* fs, const sef_shared_dictionary_t* shared) {
+    sef_state_clear(fs);
+    fs->shared_dictionary = shared;
+    const sef_unsigned_t* data = (const sef_unsigned_t*) shared->data;
+    sef_unsigned_t* memory = (sef_unsigned_t*) fs->forth_memory;
+    for (size_t i=0; i<shared->data_size/sizeof(sef_int_t); i++) {
+        bool relocated = shared->data_relocations[i / 8] & (1 << (i % 8));
+        memory[i] = relocated ? data[i] + (sef_unsigned_t) fs : data[i];
+    }
+    fs->here.byte = fs->forth_memory + shared->data_size;
+    // The indexes of the state start empty, the words being found through the
+    // ones of the shared dictionary.
+    fs->last_dictionary_entry = shared->last_entry;
+    fs->last_indexed_entry = shared->last_entry;
+    memcpy(fs->word_cache, shared->word_cache, sizeof(fs->word_cache));
+    fs->wordlist_count = shared->wordlist_count;
+    fs->optimized_cells = shared->optimized_cells;
+    fs->compiling_system_words = false;
+}
+#endif
+
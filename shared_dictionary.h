@@ -0,0 +1,60 @@
+#include "private_api.h"
+#ifndef SHARED_DICTIONARY_H
+#define SHARED_DICTIONARY_H
+
+#if SEF_SHARED_DICTIONARY
+// The system words, compiled once in a read-only mapping searched by the states
+// after their own dictionary. The words made with `create`, such as variables
+// or values, keep their body in the memory of each state, at the offset stored
+// in the first cell of their body in the mapping, and their code field is set
+// to OP_DOSHAREDCREATE or OP_DOSHAREDDOES.
+struct sef_shared_dictionary_s {
+    size_t mapped_size;
+    dictionary_entry_t last_entry;
+    dictionary_entry_t buckets[SEF_DICTIONARY_BUCKETS];
+    dictionary_entry_t* entries; // Sorted by address.
+    sef_int_t entry_count;
+    uint8_t* memory;
+    uint8_t* memory_end;
+    sef_int_t wordlist_count;
+    sef_int_t optimized_cells;
+    dictionary_entry_t word_cache[WORD_IN_CACHE_COUNT];
+    // Start of the memory of each state, holding the bodies of the words made
+    // with `create`. The cells with a bit set in the bitmap are offsets from
+    // the start of the state.
+    size_t data_size;
+    const uint8_t* data;
+    const uint8_t* data_relocations;
+};
+
+// Compile the system words in a new shared dictionary. Return NULL if it
+// couldn't be made.
+sef_shared_dictionary_t* sef_shared_dictionary_new(void);
+
+void sef_shared_dictionary_free(sef_shared_dictionary_t* shared);
+
+// Initialize the state with only the memory of its own and the search order,
+// the words being found in the shared dictionary.
+void sef_shared_state_init(forth_state_t* fs, const sef_shared_dictionary_t* shared);
+
+static inline bool sef_is_in_shared_dictionary(forth_state_t* fs, const void* p) {
+    const sef_shared_dictionary_t* shared = fs->shared_dictionary;
+    return shared != NULL && (const uint8_t*) p >= shared->memory && (const uint8_t*) p < shared->memory_end;
+}
+#endif
+
+// Address of the body of a word made with `create`, as returned by `>body`.
+static inline void* sef_get_entry_body(forth_state_t* fs, dictionary_entry_t entry) {
+#if SEF_SHARED_DICTIONARY
+    sef_int_t opcode = *sef_get_entry_code_field(entry);
+    if (opcode == OP_DOSHAREDCREATE || opcode == OP_DOSHAREDDOES) {
+        return fs->forth_memory + *(sef_int_t*) sef_get_entry_parameter(entry);
+    }
+#else
+    UNUSED(fs);
+#endif
+    return sef_get_entry_parameter(entry);
+}
+
+#endif
+
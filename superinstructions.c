@@ -0,0 +1,148 @@
+#include "private_api.h"
+#include "string.h"
+
+/* ---------------------------- Superinstructions --------------------------- */
+
+#if SEF_SUPERINSTRUCTIONS
+struct superinstruction_s {
+    enum word_in_cache fused;
+    enum word_in_cache sequence[SUPERINSTRUCTION_MAX_LENGTH];
+    size_t length;
+};
+
+// Sequences of words replaced with a single superinstruction. (literal) and
+// the branches take the cell after them as part of the instruction.
+static const struct superinstruction_s superinstructions[] = {
+    {PAREN_LITERAL_ADD, {PAREN_LITERAL, ADD}, 2},
+    {DUP_ZERO_BRANCH, {DUP, ZERO_BRANCH}, 2},
+    {EQ0_ZERO_BRANCH, {EQ0, ZERO_BRANCH}, 2},
+    {OVER_OVER, {OVER, OVER}, 2},
+    {R_FROM_DROP, {R_FROM, DROP}, 2},
+    {SWAP_DROP, {SWAP, DROP}, 2},
+};
+
+static void forget_instructions(forth_state_t* fs) {
+    for (size_t i=0; i<SUPERINSTRUCTION_MAX_LENGTH; i++) {
+        fs->last_instructions[i] = NULL;
+    }
+}
+
+// Tells if the last compiled instructions are the given sequence.
+static bool last_instructions_match(forth_state_t* fs, const struct superinstruction_s* superinstruction) {
+    for (size_t i=0; i<superinstruction->length; i++) {
+        sef_int_t* instruction = fs->last_instructions[SUPERINSTRUCTION_MAX_LENGTH - superinstruction->length + i];
+        dictionary_entry_t word = fs->word_cache[superinstruction->sequence[i]];
+        if (instruction == NULL || word == NULL || *instruction != (sef_int_t) word) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only the first cell of the sequence is replaced. The other cells are kept as
+// they are, the superinstruction skips them. This way, the addresses used by
+// the control-flow words stay valid and jumping in the middle of a sequence
+// executes its remaining words as usual.
+bool sef_compile_instruction(forth_state_t* fs, sef_int_t* instruction) {
+    if (instruction != fs->last_instructions_end) { // Something else was compiled in between
+        forget_instructions(fs);
+    }
+    for (size_t i=0; i<SUPERINSTRUCTION_MAX_LENGTH-1; i++) {
+        fs->last_instructions[i] = fs->last_instructions[i+1];
+    }
+    fs->last_instructions[SUPERINSTRUCTION_MAX_LENGTH-1] = instruction;
+    fs->last_instructions_end = fs->here.cell;
+
+    for (size_t i=0; i<sizeof(superinstructions) / sizeof(struct superinstruction_s); i++) {
+        const struct superinstruction_s* superinstruction = &superinstructions[i];
+        if (last_instructions_match(fs, superinstruction)) {
+            sef_int_t* first = fs->last_instructions[SUPERINSTRUCTION_MAX_LENGTH - superinstruction->length];
+            *first = (sef_int_t) sef_get_word_from_cache(fs, superinstruction->fused);
+            forget_instructions(fs);
+            return true;
+        }
+    }
+    return false;
+}
+
+dictionary_entry_t sef_superinstruction_first_word(forth_state_t* fs, dictionary_entry_t entry) {
+    for (size_t i=0; i<sizeof(superinstructions) / sizeof(struct superinstruction_s); i++) {
+        const struct superinstruction_s* superinstruction = &superinstructions[i];
+        if (entry == fs->word_cache[superinstruction->fused]) {
+            return fs->word_cache[superinstruction->sequence[0]];
+        }
+    }
+    return entry;
+}
+#else
+bool sef_compile_instruction(forth_state_t* fs, sef_int_t* instruction) {
+    UNUSED(fs);
+    UNUSED(instruction);
+    return false;
+}
+
+dictionary_entry_t sef_superinstruction_first_word(forth_state_t* fs, dictionary_entry_t entry) {
+    UNUSED(fs);
+    return entry;
+}
+#endif
+
+/* ----------------------------- Pairs profiling ---------------------------- */
+
+#if SEF_PROFILE_PAIRS
+#define PAIRS_TABLE_SIZE 1024
+#define PAIRS_MAX_PROBES 16
+#define PAIRS_TO_PRINT 20
+
+struct pair_s {
+    dictionary_entry_t first;
+    dictionary_entry_t second;
+    sef_unsigned_t count;
+};
+
+// This is global to all states, as the segfault recovery.
+static struct pair_s pairs[PAIRS_TABLE_SIZE];
+static dictionary_entry_t previous_entry = NULL;
+
+void sef_profile_dispatch(dictionary_entry_t entry) {
+    dictionary_entry_t first = previous_entry;
+    previous_entry = entry;
+    if (first == NULL) {
+        return;
+    }
+    size_t hash = (((size_t) first * 31) ^ (size_t) entry) / sizeof(sef_int_t);
+    for (size_t i=0; i<PAIRS_MAX_PROBES; i++) {
+        struct pair_s* pair = &pairs[(hash + i) % PAIRS_TABLE_SIZE];
+        if (pair->count == 0) {
+            pair->first = first;
+            pair->second = entry;
+        }
+        if (pair->first == first && pair->second == entry) {
+            pair->count++;
+            return;
+        }
+    }
+    // The table is too crowded, this pair is not counted
+}
+
+static int compare_pairs(const void* a, const void* b) {
+    sef_unsigned_t count_a = ((const struct pair_s*) a)->count;
+    sef_unsigned_t count_b = ((const struct pair_s*) b)->count;
+    return (count_a < count_b) - (count_a > count_b);
+}
+
+void sef_print_pairs(forth_state_t* fs) {
+    char* pad = (char*) fs->pad;
+    qsort(pairs, PAIRS_TABLE_SIZE, sizeof(struct pair_s), compare_pairs);
+    sef_print_string("Most frequent pairs of words:\n");
+    for (size_t i=0; i<PAIRS_TO_PRINT && pairs[i].count != 0; i++) {
+        snprintf(pad, SEF_PAD_SIZE, "  * %lu %s ", (unsigned long) pairs[i].count, sef_get_entry_name(pairs[i].first));
+        sef_print_string(pad);
+        sef_print_string(sef_get_entry_name(pairs[i].second));
+        sef_print_string("\n");
+    }
+    memset(pairs, 0, sizeof(pairs));
+    previous_entry = NULL;
+}
+#endif
+
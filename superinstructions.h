@@ -0,0 +1,27 @@
+#include "private_api.h"
+#ifndef SUPERINSTRUCTIONS_H
+#define SUPERINSTRUCTIONS_H
+
+// Maximum number of words fused in a single superinstruction.
+#define SUPERINSTRUCTION_MAX_LENGTH 3
+
+// Must be called after compiling a whole instruction, a word and its inline
+// operands, that starts at the given address. If the last compiled
+// instructions form a known sequence, the first one is replaced by the
+// matching superinstruction and true is returned.
+bool sef_compile_instruction(forth_state_t* fs, sef_int_t* instruction);
+
+// If the given entry is a superinstruction, return the first word of the
+// sequence it replaces. Otherwise, return the entry itself.
+dictionary_entry_t sef_superinstruction_first_word(forth_state_t* fs, dictionary_entry_t entry);
+
+#if SEF_PROFILE_PAIRS
+// Count the word about to be executed with the previously executed one.
+void sef_profile_dispatch(dictionary_entry_t entry);
+
+// Print the most frequent pairs of words and reset the counts.
+void sef_print_pairs(forth_state_t* fs);
+#endif
+
+#endif
+
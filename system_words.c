@@ -0,0 +1,79 @@
+#include "forth_state.h"
+
+// The system words are compiled from their Forth source by this file. Unless
+// SEF_PRECOMPILED_DICTIONARY is 0, this is only done when libseforth is built,
+// so that the sources are not linked in the programs using it.
+
+#define PARSE_STRING(fs, str) sef_eval_string((sef_forth_state_t*) (fs), (str))
+
+// Called after each set of system words is compiled, with the name of the set.
+// This does nothing but can be overridden to follow how long compiling them takes.
+void __attribute__((weak)) sef_system_words_compiled(sef_forth_state_t* state, const char* set_name) {
+    UNUSED(state);
+    UNUSED(set_name);
+}
+
+#define COMPILE_WORD_SET(fs, set)                                     \
+    PARSE_STRING(fs, set);                                            \
+    sef_system_words_compiled((sef_forth_state_t*) (fs), #set)
+
+static void compile_system_forth_words(forth_state_t* fs) {
+    (void) fs;
+#if !SEF_NATIVE_CORE_WORDS
+    extern const char* tiny_core_forth_words;
+    COMPILE_WORD_SET(fs, tiny_core_forth_words);
+#endif
+    extern const char* core_forth_words;
+    COMPILE_WORD_SET(fs, core_forth_words);
+    // The pre-processor would corrupt comments definitions
+    PARSE_STRING(fs, ": ( [char] ) parse 2drop ; immediate");
+    PARSE_STRING(fs, ": \\ 10 parse 2drop ; immediate");
+    sef_system_words_compiled((sef_forth_state_t*) fs, "comments");
+#if SEF_FILE_ACCESS || SEF_BLOCK
+    extern const char* linked_list;
+    COMPILE_WORD_SET(fs, linked_list);
+#endif
+#if SEF_PROGRAMMING_TOOLS
+    extern const char* tools_forth_words;
+    COMPILE_WORD_SET(fs, tools_forth_words);
+#endif
+    extern const char* shell;
+    COMPILE_WORD_SET(fs, shell);
+#if SEF_ARG_AND_EXIT_CODE
+    sef_push_data(fs, (sef_int_t) &fs->exit_code); // Push the address of the exit code to map it to the word EXIT-CODE.
+    extern const char* arg_and_exit_code_forth_words;
+    COMPILE_WORD_SET(fs, arg_and_exit_code_forth_words);
+#endif
+#if SEF_SEARCH_ORDER
+    extern const char* search_order_forth_words;
+    COMPILE_WORD_SET(fs, search_order_forth_words);
+#endif
+#if SEF_STRING
+    extern const char* string_forth_words;
+    COMPILE_WORD_SET(fs, string_forth_words);
+#endif
+#if SEF_BLOCK
+    extern const char* block_forth_words;
+    PARSE_STRING(fs, block_forth_words);
+    PARSE_STRING(fs, ": \\ blk @ 0= if ['] \\ execute else >in @ block-line-len mod >in @ swap - block-line-len + >in ! then ; immediate");
+    sef_system_words_compiled((sef_forth_state_t*) fs, "block_forth_words");
+#endif
+#if SEF_PROGRAMMING_TOOLS && SEF_ARG_AND_EXIT_CODE
+    PARSE_STRING(fs, ": (bye) exit-code ! bye ;");
+    sef_system_words_compiled((sef_forth_state_t*) fs, "(bye)");
+#endif
+}
+
+// Init the interpreter by compiling the system words
+void sef_compile_system_words(forth_state_t* fs) {
+    sef_state_clear(fs);
+    sef_register_default_cfunc(fs);
+    sef_fill_c_func_in_cache(fs);
+    sef_register_parser_cfunc(fs);
+    sef_fill_parser_c_func_in_cache(fs);
+    sef_register_block_cfunc(fs);
+    sef_system_words_compiled((sef_forth_state_t*) fs, "C words");
+    compile_system_forth_words(fs);
+    sef_fill_forth_words_in_cache(fs);
+    fs->compiling_system_words = false;
+}
@@ -3,22 +3,39 @@
 const char* const words_to_cache[WORD_IN_CACHE_COUNT] = {
     [ABORT] = "abort",
     [EXIT] = "exit",
-    [IF] = "if",
-    [ELSE] = "else",
-    [WHILE] = "while",
-    [REPEAT] = "repeat",
-    [QUESTION_DO] = "?do",
-    [DO] = "do",
-    [PLUS_LOOP] = "+loop",
-    [LOOP] = "loop",
-    [OF] = "of",
-    [ENDOF] = "endof",
+    [ZERO_BRANCH] = "(0branch)",
+    [BRANCH] = "(branch)",
+    [QUESTION_DO] = "(?do)",
+    [DO] = "(do)",
+    [PLUS_LOOP] = "(+loop)",
+    [LOOP] = "(loop)",
+    [PAREN_OF] = "(of)",
     [DROP] = "drop",
     [POSTPONE] = "postpone",
     [PAREN_LITERAL] = "(literal)",
+    [DUP] = "dup",
+    [SWAP] = "swap",
+    [R_FROM] = "r>",
+    [TO_R] = ">r",
+    [EQ0] = "0=",
+    [ADD] = "+",
+    [LESS0] = "0<",
+    [ONE_PLUS] = "1+",
+    [ONE_MINUS] = "1-",
+    [NOT_EQ0] = "0<>",
+    [GREATER0] = "0>",
+    [CODE_POINTER] = "code-pointer",
+    [DOES] = "does>",
+    [PAREN_LITERAL_ADD] = "(literal-+)",
+    [DUP_ZERO_BRANCH] = "(dup-0branch)",
+    [EQ0_ZERO_BRANCH] = "(0=-0branch)",
+    [OVER_OVER] = "(over-over)",
+    [R_FROM_DROP] = "(r>-drop)",
+    [SWAP_DROP] = "(swap-drop)",
     [S_TO_D] = "s>d",
     [ALIGN] = "align",
     [REPL] = "(repl)",
+    [OVER] = "over",
     [BLOCK_FILE_DATA] = "block_file_data",
 };
 
@@ -38,25 +55,47 @@ void sef_add_word_in_cache(forth_state_t* fs, dictionary_entry_t entry, enum wor
 void sef_fill_c_func_in_cache(forth_state_t* fs) {
     automaticaly_add_word_in_cache(fs, ABORT);
     automaticaly_add_word_in_cache(fs, EXIT);
-    automaticaly_add_word_in_cache(fs, IF);
-    automaticaly_add_word_in_cache(fs, ELSE);
-    automaticaly_add_word_in_cache(fs, WHILE);
-    automaticaly_add_word_in_cache(fs, REPEAT);
+    automaticaly_add_word_in_cache(fs, ZERO_BRANCH);
+    automaticaly_add_word_in_cache(fs, BRANCH);
     automaticaly_add_word_in_cache(fs, QUESTION_DO);
     automaticaly_add_word_in_cache(fs, DO);
     automaticaly_add_word_in_cache(fs, PLUS_LOOP);
     automaticaly_add_word_in_cache(fs, LOOP);
-    automaticaly_add_word_in_cache(fs, OF);
-    automaticaly_add_word_in_cache(fs, ENDOF);
+    automaticaly_add_word_in_cache(fs, PAREN_OF);
     automaticaly_add_word_in_cache(fs, DROP);
     automaticaly_add_word_in_cache(fs, POSTPONE);
     automaticaly_add_word_in_cache(fs, PAREN_LITERAL);
+    automaticaly_add_word_in_cache(fs, DUP);
+    automaticaly_add_word_in_cache(fs, SWAP);
+    automaticaly_add_word_in_cache(fs, R_FROM);
+    automaticaly_add_word_in_cache(fs, TO_R);
+    automaticaly_add_word_in_cache(fs, EQ0);
+    automaticaly_add_word_in_cache(fs, ADD);
+    automaticaly_add_word_in_cache(fs, LESS0);
+#if SEF_NATIVE_CORE_WORDS
+    automaticaly_add_word_in_cache(fs, ONE_PLUS);
+    automaticaly_add_word_in_cache(fs, ONE_MINUS);
+    automaticaly_add_word_in_cache(fs, NOT_EQ0);
+    automaticaly_add_word_in_cache(fs, GREATER0);
+#endif
+    automaticaly_add_word_in_cache(fs, CODE_POINTER);
+    automaticaly_add_word_in_cache(fs, PAREN_LITERAL_ADD);
+    automaticaly_add_word_in_cache(fs, DUP_ZERO_BRANCH);
+    automaticaly_add_word_in_cache(fs, EQ0_ZERO_BRANCH);
+    automaticaly_add_word_in_cache(fs, OVER_OVER);
+    automaticaly_add_word_in_cache(fs, R_FROM_DROP);
+    automaticaly_add_word_in_cache(fs, SWAP_DROP);
+}
+
+void sef_fill_parser_c_func_in_cache(forth_state_t* fs) {
+    automaticaly_add_word_in_cache(fs, DOES);
 }
 
 void sef_fill_forth_words_in_cache(forth_state_t* fs) {
     automaticaly_add_word_in_cache(fs, S_TO_D);
     automaticaly_add_word_in_cache(fs, ALIGN);
     automaticaly_add_word_in_cache(fs, REPL);
+    automaticaly_add_word_in_cache(fs, OVER);
 }
 
 dictionary_entry_t sef_get_word_from_cache(forth_state_t* fs, enum word_in_cache word) {
@@ -5,23 +5,42 @@ enum word_in_cache {
     // Words defined in C
     ABORT,
     EXIT,
-    IF,
-    ELSE,
-    WHILE,
-    REPEAT,
+    ZERO_BRANCH,
+    BRANCH,
     QUESTION_DO,
     DO,
     PLUS_LOOP,
     LOOP,
-    OF,
-    ENDOF,
+    PAREN_OF,
     DROP,
     POSTPONE,
     PAREN_LITERAL,
+    DUP,
+    SWAP,
+    R_FROM,
+    TO_R,
+    EQ0,
+    ADD,
+    LESS0,
+    ONE_PLUS,
+    ONE_MINUS,
+    NOT_EQ0,
+    GREATER0,
+    CODE_POINTER,
+    // Words defined in C by the parser
+    DOES,
+    // Superinstructions
+    PAREN_LITERAL_ADD,
+    DUP_ZERO_BRANCH,
+    EQ0_ZERO_BRANCH,
+    OVER_OVER,
+    R_FROM_DROP,
+    SWAP_DROP,
     // Words defined in forth
     S_TO_D,
     ALIGN,
     REPL,
+    OVER,
     // Weird one
     BLOCK_FILE_DATA,
 
@@ -29,6 +48,7 @@ enum word_in_cache {
 };
 
 void sef_fill_c_func_in_cache(forth_state_t* fs);
+void sef_fill_parser_c_func_in_cache(forth_state_t* fs);
 void sef_fill_forth_words_in_cache(forth_state_t* fs);
 void sef_add_word_in_cache(forth_state_t* fs, dictionary_entry_t entry, enum word_in_cache word);
 